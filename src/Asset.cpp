@@ -0,0 +1,630 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Asset.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+
+#include "Asset.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Simd.hpp"
+#include "Memory.hpp"
+#include "Thread.hpp"
+#include "Job.hpp"
+#include "Debug.hpp"
+
+
+#define BMR_ASSET_HEADER_SIZE AlignUp(sizeof(BMR::Asset), BMR_CACHE_LINE_SIZE)
+#define BMR_ASSET_ARENA_HEADER_SIZE AlignUp(sizeof(BMR::_AssetArena), BMR_CACHE_LINE_SIZE)
+
+// NOTE(ilya.a): Compression field of BITMAPINFOHEADER.
+// [https://learn.microsoft.com/en-us/windows/win32/api/wingdi/ns-wingdi-bitmapinfoheader]
+#define BMR_BMP_RGB            0
+#define BMR_BMP_BITFIELDS      3
+#define BMR_BMP_ALPHABITFIELDS 6
+
+#define BMR_BMP_FILE_HEADER_SIZE 14
+#define BMR_BMP_INFO_HEADER_SIZE 40
+#define BMR_BMP_MASKS_OFFSET     (BMR_BMP_FILE_HEADER_SIZE + BMR_BMP_INFO_HEADER_SIZE)
+
+// NOTE(ilya.a): [https://qoiformat.org/qoi-specification.pdf]
+#define BMR_QOI_HEADER_SIZE  14
+#define BMR_QOI_PADDING_SIZE 8
+
+#define BMR_QOI_OP_RGB  0xFE
+#define BMR_QOI_OP_RGBA 0xFF
+
+
+namespace BMR {
+
+    /*
+     * Memory of batch, which is bumped by workers concurrently. It's sized
+     * for header and small surface of every file, so it never runs out.
+     */
+    struct _AssetArena {
+        volatile U64 Used;
+        volatile U64 References;  // NOTE(ilya.a): Assets, which are alive.
+        Size Capacity;
+        Size MemorySize;
+    };
+
+    InternalFunc _AssetArena *
+    _AssetArena_Create(U64 count) noexcept
+    {
+        Size capacity = (Size)count * (BMR_ASSET_HEADER_SIZE + BMR_ASSET_SMALL_SIZE);
+        Size size = BMR_ASSET_ARENA_HEADER_SIZE + capacity;
+
+        auto *arena = (_AssetArena *)Memory_Allocate(size);
+        if (arena == nullptr) {
+            return nullptr;
+        }
+
+        arena->Used = 0;
+        arena->References = 0;
+        arena->Capacity = capacity;
+        arena->MemorySize = size;
+        return arena;
+    }
+
+    /*
+     * Returns `nullptr`, if there's no arena or it has no room left.
+     */
+    InternalFunc void *
+    _AssetArena_Push(_AssetArena *arena, Size size) noexcept
+    {
+        if (arena == nullptr || size > arena->Capacity) {
+            return nullptr;
+        }
+
+        U64 offset = Atomic_FetchAdd(&arena->Used, size);
+        if (offset > arena->Capacity - size) {
+            return nullptr;
+        }
+
+        return (U8 *)arena + BMR_ASSET_ARENA_HEADER_SIZE + offset;
+    }
+
+    InternalFunc void
+    _AssetArena_Release(_AssetArena *arena) noexcept
+    {
+        if (Atomic_FetchAdd(&arena->References, (U64)-1) == 1) {
+            Memory_Free(arena, arena->MemorySize);
+        }
+    }
+
+    /*
+     * Asset header, which is taken from `arena`, if `size` is small enough,
+     * and allocated on its own otherwise.
+     */
+    InternalFunc Asset *
+    _AllocateHeader(_AssetArena *arena, Size size) noexcept
+    {
+        Asset *asset = nullptr;
+
+        if (size <= BMR_ASSET_HEADER_SIZE + BMR_ASSET_SMALL_SIZE) {
+            asset = (Asset *)_AssetArena_Push(arena, size);
+        }
+
+        if (asset != nullptr) {
+            Atomic_FetchAdd(&arena->References, 1);
+            *asset = Asset{};
+            asset->Arena = arena;
+        } else {
+            asset = (Asset *)Memory_Allocate(size);
+            if (asset == nullptr) {
+                Debug_Print("Failed to allocate memory for asset!\n");
+                return nullptr;
+            }
+        }
+
+        asset->MemorySize = size;
+        return asset;
+    }
+
+    InternalFunc inline U32
+    _Read16(const U8 *p) noexcept
+    {
+        return (U32)p[0] | ((U32)p[1] << 8);
+    }
+
+    InternalFunc inline U32
+    _Read32(const U8 *p) noexcept
+    {
+        return (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16) | ((U32)p[3] << 24);
+    }
+
+    InternalFunc inline U32
+    _Read32BE(const U8 *p) noexcept
+    {
+        return ((U32)p[0] << 24) | ((U32)p[1] << 16) | ((U32)p[2] << 8) | (U32)p[3];
+    }
+
+    /*
+     * Allocates asset together with pixels of `w` by `h` surface, so
+     * loading of small sprite costs single allocation, or none at all,
+     * if it's taken from `arena`.
+     */
+    InternalFunc Asset *
+    _Allocate(_AssetArena *arena, U32 w, U32 h) noexcept
+    {
+        U64 pitch = AlignUp((Size)w * sizeof(Color4), BMR_CACHE_LINE_SIZE);
+        Size size = BMR_ASSET_HEADER_SIZE + (Size)pitch * h;
+
+        Asset *asset = _AllocateHeader(arena, size);
+        if (asset == nullptr) {
+            return nullptr;
+        }
+
+        asset->Pixels.Buffer = (U8 *)asset + BMR_ASSET_HEADER_SIZE;
+        asset->Pixels.Width = w;
+        asset->Pixels.Height = h;
+        asset->Pixels.Pitch = pitch;
+        asset->Pixels.Format = PixelFormat::BGRA8888;
+        return asset;
+    }
+
+    InternalFunc inline U32 *
+    _GetRow(const Surface *s, U64 y) noexcept
+    {
+        return (U32 *)((U8 *)s->Buffer + y * s->Pitch);
+    }
+
+    /*
+     * Forces alpha of `count` pixels to opaque.
+     */
+    InternalFunc void
+    _FillAlpha(U32 *pixels, U64 count) noexcept
+    {
+        U64 i = 0;
+
+#if BMR_SIMD_SSE2
+        const __m128i alpha = _mm_set1_epi32((S32)0xFF000000);
+        for (; i + 4 <= count; i += 4) {
+            __m128i p = _mm_loadu_si128((const __m128i *)(pixels + i));
+            _mm_storeu_si128((__m128i *)(pixels + i), _mm_or_si128(p, alpha));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            pixels[i] |= 0xFF000000;
+        }
+    }
+
+    struct _Bmp_Info {
+        U32 Width;
+        U32 Height;
+        bool IsTopDown;
+        bool IsAlphaReserved;  // NOTE(ilya.a): See `_HasAlpha`.
+
+        U32 BitCount;
+        U32 Masks[4];  // NOTE(ilya.a): Red, green, blue and alpha.
+
+        const U8 *Palette;  // NOTE(ilya.a): BGRX entries.
+        U32 PaletteCount;
+
+        const U8 *Pixels;
+        Size Pitch;
+    };
+
+    InternalFunc bool
+    _ParseBmp(const U8 *data, Size size, Out _Bmp_Info *info) noexcept
+    {
+        *info = _Bmp_Info{};
+
+        if (size < BMR_BMP_FILE_HEADER_SIZE + BMR_BMP_INFO_HEADER_SIZE) {
+            return false;
+        }
+
+        Size offset = _Read32(data + 10);
+        Size headerSize = _Read32(data + 14);
+        S64 width = (S32)_Read32(data + 18);
+        S64 height = (S32)_Read32(data + 22);
+        U32 compression = _Read32(data + 30);
+        U32 colorsUsed = _Read32(data + 46);
+
+        info->BitCount = _Read16(data + 28);
+
+        // NOTE(ilya.a): OS/2 headers are 12 bytes and are not supported.
+        if (headerSize < BMR_BMP_INFO_HEADER_SIZE || size < BMR_BMP_FILE_HEADER_SIZE + headerSize
+            || _Read16(data + 26) != 1) {
+            return false;
+        }
+
+        if (width <= 0 || width > BMR_ASSET_MAX_SIZE || height == 0
+            || height > BMR_ASSET_MAX_SIZE || height < -BMR_ASSET_MAX_SIZE) {
+            return false;
+        }
+
+        info->Width = (U32)width;
+        info->Height = (U32)(height < 0 ? -height : height);
+        info->IsTopDown = height < 0;
+
+        switch (compression) {
+            case (BMR_BMP_RGB): {
+                if (info->BitCount != 8 && info->BitCount != 24 && info->BitCount != 32) {
+                    return false;
+                }
+
+                info->IsAlphaReserved = true;
+                info->Masks[0] = 0x00FF0000;
+                info->Masks[1] = 0x0000FF00;
+                info->Masks[2] = 0x000000FF;
+                info->Masks[3] = 0xFF000000;
+            } break;
+            case (BMR_BMP_BITFIELDS):
+            case (BMR_BMP_ALPHABITFIELDS): {
+                // NOTE(ilya.a): Masks follow BITMAPINFOHEADER, or are part of
+                // bigger header, either way they are at the same offset.
+                bool hasAlpha = compression == BMR_BMP_ALPHABITFIELDS
+                    || headerSize >= BMR_BMP_INFO_HEADER_SIZE + 16;
+                if (info->BitCount != 32 || size < BMR_BMP_MASKS_OFFSET + 16) {
+                    return false;
+                }
+
+                info->Masks[0] = _Read32(data + BMR_BMP_MASKS_OFFSET);
+                info->Masks[1] = _Read32(data + BMR_BMP_MASKS_OFFSET + 4);
+                info->Masks[2] = _Read32(data + BMR_BMP_MASKS_OFFSET + 8);
+                info->Masks[3] = hasAlpha ? _Read32(data + BMR_BMP_MASKS_OFFSET + 12) : 0;
+            } break;
+            default: {
+                return false;
+            } break;
+        }
+
+        if (info->BitCount == 8) {
+            info->PaletteCount = colorsUsed != 0 ? colorsUsed : 256;
+            info->Palette = data + BMR_BMP_FILE_HEADER_SIZE + headerSize;
+
+            if (info->PaletteCount > 256
+                || BMR_BMP_FILE_HEADER_SIZE + headerSize + (Size)info->PaletteCount * 4 > size) {
+                return false;
+            }
+        }
+
+        // NOTE(ilya.a): Rows are padded to 4 bytes.
+        info->Pitch = ((Size)info->Width * info->BitCount + 31) / 32 * 4;
+        if (offset > size || (Size)info->Height * info->Pitch > size - offset) {
+            return false;
+        }
+
+        info->Pixels = data + offset;
+        return true;
+    }
+
+    InternalFunc inline const U8 *
+    _GetBmpRow(const _Bmp_Info &info, U64 y) noexcept
+    {
+        U64 row = info.IsTopDown ? y : info.Height - 1 - y;
+        return info.Pixels + row * info.Pitch;
+    }
+
+    /*
+     * Alpha of `BI_RGB` is reserved, and most writers leave it zero. Image,
+     * which has no alpha at all, is treated as opaque.
+     */
+    InternalFunc bool
+    _HasAlpha(const _Bmp_Info &info) noexcept
+    {
+        for (U64 y = 0; y < info.Height; ++y) {
+            const U8 *row = _GetBmpRow(info, y);
+
+            for (U64 x = 0; x < info.Width; ++x) {
+                if (row[x * 4 + 3] != 0) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /*
+     * Channel, which is selected by `mask`, scaled to 8 bits.
+     */
+    InternalFunc inline U8
+    _ExtractChannel(U32 value, U32 mask) noexcept
+    {
+        if (mask == 0) {
+            return MAX_U8;
+        }
+
+        U32 shift = 0;
+        while (((mask >> shift) & 1) == 0) {
+            ++shift;
+        }
+
+        U32 max = mask >> shift;
+        U32 channel = (value & mask) >> shift;
+        return (U8)(max == MAX_U8 ? channel : (U64)channel * MAX_U8 / max);
+    }
+
+    InternalFunc void
+    _DecodeBmpRow(const _Bmp_Info &info, const U8 *src, Out U32 *dst) noexcept
+    {
+        switch (info.BitCount) {
+            case (8): {
+                for (U64 x = 0; x < info.Width; ++x) {
+                    U32 index = src[x];
+                    dst[x] = index < info.PaletteCount
+                        ? _Read32(info.Palette + index * 4) | 0xFF000000 : 0xFF000000;
+                }
+            } break;
+            case (24): {
+                for (U64 x = 0; x < info.Width; ++x, src += 3) {
+                    dst[x] = (U32)src[0] | ((U32)src[1] << 8) | ((U32)src[2] << 16) | 0xFF000000;
+                }
+            } break;
+            case (32):
+            default: {
+                for (U64 x = 0; x < info.Width; ++x, src += 4) {
+                    U32 value = _Read32(src);
+                    Color4 c = Color4(
+                        _ExtractChannel(value, info.Masks[0]), _ExtractChannel(value, info.Masks[1]),
+                        _ExtractChannel(value, info.Masks[2]), _ExtractChannel(value, info.Masks[3]));
+                    memcpy(dst + x, &c, sizeof(c));
+                }
+            } break;
+        }
+    }
+
+    InternalFunc Asset *
+    _LoadBmp(_AssetArena *arena, const U8 *data, Size size, Out bool *isMapped) noexcept
+    {
+        _Bmp_Info info;
+        if (!_ParseBmp(data, size, &info)) {
+            return nullptr;
+        }
+
+        bool isBGRA = info.BitCount == 32
+            && info.Masks[0] == 0x00FF0000 && info.Masks[1] == 0x0000FF00
+            && info.Masks[2] == 0x000000FF && info.Masks[3] == 0xFF000000;
+        bool isOpaque = info.BitCount == 32 && info.IsAlphaReserved && !_HasAlpha(info);
+
+        // NOTE(ilya.a): Pixels are used in place. Mapping is read only, so
+        // image, which alpha has to be fixed up, is copied instead.
+        if (isBGRA && !isOpaque && info.IsTopDown && ((Size)(info.Pixels - data) % sizeof(U32)) == 0) {
+            Asset *asset = _AllocateHeader(arena, BMR_ASSET_HEADER_SIZE);
+            if (asset == nullptr) {
+                return nullptr;
+            }
+
+            asset->Pixels.Buffer = (void *)info.Pixels;
+            asset->Pixels.Width = info.Width;
+            asset->Pixels.Height = info.Height;
+            asset->Pixels.Pitch = info.Pitch;
+            asset->Pixels.Format = PixelFormat::BGRA8888;
+
+            *isMapped = true;
+            return asset;
+        }
+
+        Asset *asset = _Allocate(arena, info.Width, info.Height);
+        if (asset == nullptr) {
+            return nullptr;
+        }
+
+        for (U64 y = 0; y < info.Height; ++y) {
+            U32 *dst = _GetRow(&asset->Pixels, y);
+
+            if (isBGRA) {
+                memcpy(dst, _GetBmpRow(info, y), (Size)info.Width * sizeof(U32));
+            } else {
+                _DecodeBmpRow(info, _GetBmpRow(info, y), dst);
+            }
+
+            if (isOpaque) {
+                _FillAlpha(dst, info.Width);
+            }
+        }
+
+        *isMapped = false;
+        return asset;
+    }
+
+    InternalFunc inline U32
+    _HashQoi(const Color4 &c) noexcept
+    {
+        return (c.R * 3 + c.G * 5 + c.B * 7 + c.A * 11) % 64;
+    }
+
+    InternalFunc Asset *
+    _LoadQoi(_AssetArena *arena, const U8 *data, Size size) noexcept
+    {
+        if (size < BMR_QOI_HEADER_SIZE + BMR_QOI_PADDING_SIZE) {
+            return nullptr;
+        }
+
+        U32 width = _Read32BE(data + 4);
+        U32 height = _Read32BE(data + 8);
+        U8 channels = data[12];
+
+        if (width == 0 || width > BMR_ASSET_MAX_SIZE || height == 0 || height > BMR_ASSET_MAX_SIZE
+            || (channels != 3 && channels != 4)) {
+            return nullptr;
+        }
+
+        Asset *asset = _Allocate(arena, width, height);
+        if (asset == nullptr) {
+            return nullptr;
+        }
+
+        // NOTE(ilya.a): Longest chunk is 5 bytes, and stream is followed by
+        // 8 bytes of padding, so chunk, which starts before `end`, is never
+        // read past the file.
+        const U8 *p = data + BMR_QOI_HEADER_SIZE;
+        const U8 *end = data + size - BMR_QOI_PADDING_SIZE;
+
+        Color4 index[64] = {};
+        Color4 px = Color4(0, 0, 0, MAX_U8);
+        U32 run = 0;
+
+        for (U64 y = 0; y < height; ++y) {
+            Color4 *row = (Color4 *)_GetRow(&asset->Pixels, y);
+
+            for (U64 x = 0; x < width; ++x) {
+                if (run > 0) {
+                    --run;
+                    row[x] = px;
+                    continue;
+                }
+
+                // NOTE(ilya.a): Truncated stream repeats the last pixel.
+                if (p < end) {
+                    U8 b1 = *p++;
+
+                    if (b1 == BMR_QOI_OP_RGB) {
+                        px.R = p[0];
+                        px.G = p[1];
+                        px.B = p[2];
+                        p += 3;
+                    } else if (b1 == BMR_QOI_OP_RGBA) {
+                        px.R = p[0];
+                        px.G = p[1];
+                        px.B = p[2];
+                        px.A = p[3];
+                        p += 4;
+                    } else {
+                        switch (b1 >> 6) {
+                            case (0): {  // NOTE(ilya.a): QOI_OP_INDEX.
+                                px = index[b1];
+                            } break;
+                            case (1): {  // NOTE(ilya.a): QOI_OP_DIFF.
+                                px.R += ((b1 >> 4) & 3) - 2;
+                                px.G += ((b1 >> 2) & 3) - 2;
+                                px.B += (b1 & 3) - 2;
+                            } break;
+                            case (2): {  // NOTE(ilya.a): QOI_OP_LUMA.
+                                U8 b2 = *p++;
+                                S32 dg = (b1 & 0x3F) - 32;
+                                px.R += dg - 8 + ((b2 >> 4) & 0x0F);
+                                px.G += dg;
+                                px.B += dg - 8 + (b2 & 0x0F);
+                            } break;
+                            default: {  // NOTE(ilya.a): QOI_OP_RUN.
+                                run = b1 & 0x3F;
+                            } break;
+                        }
+                    }
+
+                    index[_HashQoi(px)] = px;
+                }
+
+                row[x] = px;
+            }
+        }
+
+        return asset;
+    }
+
+    InternalFunc Asset *
+    _Load(_AssetArena *arena, CStr path) noexcept
+    {
+        Size size = 0;
+        const U8 *data = (const U8 *)Memory_MapFile(path, &size);
+        if (data == nullptr) {
+            Debug_Print("Failed to map asset file!\n");
+            return nullptr;
+        }
+
+        Asset *asset = nullptr;
+        bool isMapped = false;
+
+        if (size >= 2 && data[0] == 'B' && data[1] == 'M') {
+            asset = _LoadBmp(arena, data, size, &isMapped);
+        } else if (size >= 4 && memcmp(data, "qoif", 4) == 0) {
+            asset = _LoadQoi(arena, data, size);
+        }
+
+        if (asset == nullptr) {
+            Debug_Print("Asset file is not supported or corrupted!\n");
+        }
+
+        if (isMapped) {
+            asset->Mapping = (void *)data;
+            asset->MappingSize = size;
+        } else {
+            Memory_UnmapFile((void *)data, size);
+        }
+
+        return asset;
+    }
+
+    Asset *
+    Asset_Load(CStr path) noexcept
+    {
+        return _Load(nullptr, path);
+    }
+
+    struct _LoadBatch_Data {
+        const CStr *Paths;
+        Asset **Assets;
+        _AssetArena *Arena;
+    };
+
+    InternalFunc void
+    _LoadBatch_Job(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        (void)worker;
+        auto *batch = (_LoadBatch_Data *)data;
+
+        for (U64 i = begin; i < end; ++i) {
+            batch->Assets[i] = _Load(batch->Arena, batch->Paths[i]);
+        }
+    }
+
+    U64
+    Asset_LoadBatch(const CStr *paths, U64 count, Out Asset **assets) noexcept
+    {
+        if (count == 0) {
+            return 0;
+        }
+
+        // NOTE(ilya.a): Without arena every asset is allocated on its own.
+        _AssetArena *arena = _AssetArena_Create(count);
+
+        // NOTE(ilya.a): Held by the batch itself, so arena isn't freed,
+        // while assets are still being loaded.
+        if (arena != nullptr) {
+            arena->References = 1;
+        }
+
+        _LoadBatch_Data batch = { paths, assets, arena };
+        Job_ParallelFor(count, BMR_ASSET_BATCH_GRAIN, _LoadBatch_Job, &batch);
+
+        if (arena != nullptr) {
+            _AssetArena_Release(arena);
+        }
+
+        U64 loaded = 0;
+        for (U64 i = 0; i < count; ++i) {
+            loaded += assets[i] != nullptr;
+        }
+        return loaded;
+    }
+
+    void
+    Asset_Destroy(Asset *asset) noexcept
+    {
+        if (asset == nullptr) {
+            return;
+        }
+
+        Memory_UnmapFile(asset->Mapping, asset->MappingSize);
+
+        if (asset->Arena != nullptr) {
+            _AssetArena_Release(asset->Arena);
+        } else {
+            Memory_Free(asset, asset->MemorySize);
+        }
+    }
+
+};  // namespace BMR
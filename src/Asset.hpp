@@ -0,0 +1,72 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Asset.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Image assets. Files are memory mapped and decoded into `BGRA8888`
+ * surfaces, which rows are padded to cache line. 32-bit BMP, which is
+ * already stored top-down in `Color4` layout, isn't decoded at all, its
+ * surface points right into the mapping and is read only. Pixel data must
+ * be aligned to 4 bytes for that, after plain 14 byte file header it's
+ * usually not, so such file is copied row by row instead. So is file,
+ * which alpha is all zero and has to be made opaque.
+ * */
+
+#ifndef SBMR_ASSET_HPP_INCLUDED
+#define SBMR_ASSET_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+
+
+#define BMR_ASSET_BATCH_GRAIN 8  // NOTE(ilya.a): Files, which are loaded by worker at once.
+
+// NOTE(ilya.a): Decoded pixels up to this size are put into memory of the
+// batch, bigger ones are allocated on their own.
+#define BMR_ASSET_SMALL_SIZE (64 * 64 * 4)
+
+
+namespace BMR {
+
+    struct _AssetArena;
+
+    struct Asset {
+        Surface Pixels;
+
+        // NOTE(ilya.a): Mapped file, which is kept only if `Pixels` are
+        // pointing into it.
+        void *Mapping;
+        Size  MappingSize;
+
+        Size MemorySize;  // NOTE(ilya.a): Of this asset and decoded pixels.
+
+        // NOTE(ilya.a): Memory of batch, which asset is allocated from, or
+        // `nullptr`, if it's allocated on its own.
+        _AssetArena *Arena;
+    };
+
+    /*
+     * Loads BMP (8, 24 and 32 bits, uncompressed or bit fields) or QOI
+     * file. Returns `nullptr`, if file can't be read or isn't supported.
+     */
+    Asset *Asset_Load(CStr path) noexcept;
+
+    /*
+     * Loads `count` files on job workers. Entries of `assets`, which failed
+     * to load, are `nullptr`. Returns number of loaded assets. Headers and
+     * small surfaces share single allocation, which is freed, when the
+     * last of them is destroyed.
+     */
+    U64 Asset_LoadBatch(const CStr *paths, U64 count, Out Asset **assets) noexcept;
+
+    void Asset_Destroy(Asset *asset) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_ASSET_HPP_INCLUDED
@@ -8,7 +8,8 @@
  * ============================================
  * */
 
-#include <Windows.h>
+#include <string.h>
+#include <math.h>
 
 #include "BMR.hpp"
 
@@ -17,11 +18,35 @@
 #include "Geom.hpp"
 #include "Coloring.hpp"
 #include "Macros.hpp"
-#include "Win32/Misc.hpp"
-#include "Win32/ScopedDC.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "Format.hpp"
+#include "Gamma.hpp"
+#include "Memory.hpp"
+#include "Backend.hpp"
+#include "Debug.hpp"
+#include "Command.hpp"
+#include "Optimize.hpp"
+#include "Tile.hpp"
+#include "Canvas.hpp"
+#include "Overdraw.hpp"
+#include "Pacing.hpp"
+#include "Time.hpp"
+#include "Thread.hpp"
+#include "Job.hpp"
+#include "Asset.hpp"
 
 
-#define BMR_RENDER_COMMAND_CAPACITY 1024
+#define BMR_TARGET_CAPACITY 16
+
+// NOTE(ilya.a): Address space for backbuffer of this size is reserved once,
+// so resizing of window never moves or reallocates it.
+#define BMR_FRAMEBUFFER_MAX_SIZE \
+    (AlignUp(BMR_FRAMEBUFFER_MAX_WIDTH * 4, BMR_CACHE_LINE_SIZE) * BMR_FRAMEBUFFER_MAX_HEIGHT)
+
+// NOTE(ilya.a): Samples of the biggest backbuffer at `scale` by `scale`
+// samples per pixel. Reserved only for the active mode.
+#define BMR_SAMPLES_MAX_SIZE(scale) (BMR_FRAMEBUFFER_MAX_SIZE * (scale) * (scale))
 
 
 /*
@@ -29,6 +54,7 @@
  */
 GlobalVar struct {
     Color4 ClearColor;
+    BMR::LineMode LineMode;
 
     struct {
         U8 *Begin;
@@ -36,219 +62,1316 @@ GlobalVar struct {
     } CommandQueue;
     U64 CommandCount;
 
-    U8 BPP;
-    U64 XOffset;
-    U64 YOffset;
-    struct {
-        void *Buffer;
-        U64 Width;
-        U64 Height;
-    } Pixels;
-    BITMAPINFO Info;
-    HWND Window;
+    // NOTE(ilya.a): Commands, which didn't fit into the queue. Frame with
+    // any of them is refused by `EndDrawing`, instead of being drawn
+    // without them.
+    U64 CommandOverflow;
+
+    bool IsOptimizing;
+    BMR::QueueStats Stats;
+
+    // NOTE(ilya.a): Hashes of commands per tile of `Pixels`, which were
+    // rasterized in previous frame.
+    bool IsTileCaching;
+    BMR::TileCache Tiles;
+
+    // NOTE(ilya.a): Per pixel counts of the last frame, which was drawn
+    // as heatmap.
+    bool IsOverdrawing;
+    BMR::Overdraw Overdraw;
+
+    BMR::Pacer Pacer;
+
+    // NOTE(ilya.a): Backbuffer is rasterized into `Samples`, which are
+    // `SampleScale` times bigger along each axis, then resolved. Commands,
+    // which are only replicated, are drawn into scratch first.
+    U32 SampleScale;
+    Surface Samples;
+    BMR::VirtualBuffer SamplesMemory;
+    BMR::VirtualBuffer SampleScratch;
+
+    // NOTE(ilya.a): Each entry is composed with ones below it. Pushes past
+    // the capacity are only counted, so pops stay balanced.
+    Transform Transforms[BMR_TRANSFORM_STACK_DEPTH];
+    U32 TransformDepth;
+    U32 TransformOverflow;
+
+    PixelFormat Format;
+    ColorPalette Palette;
+    Surface Pixels;
+
+    // NOTE(ilya.a): Copy of `Pixels` in `Layout`, which is given to window
+    // backend. Aliases `Pixels` if backbuffer is already in that layout.
+    BMR::FrameLayout Layout;
+    Surface Present;
+
+    BMR::VirtualBuffer PixelsMemory;
+    BMR::VirtualBuffer PresentMemory;
+
+    // NOTE(ilya.a): Set by window backend. Headless instance has none.
+    BMR::PresentProc PresentProc;
+
+    // NOTE(ilya.a): Memory of window backend, which `Present` is placed
+    // into, when it fits.
+    U8 *Framebuffer;
+    Size FramebufferSize;
+
+    // NOTE(ilya.a): Surface which commands are rasterized into. Either
+    // `Pixels` or one of the `Targets`. Canvas is used instead, if set.
+    Surface *Target;
+    BMR::Canvas *TargetCanvas;
+    Surface Targets[BMR_TARGET_CAPACITY];
 } Inst;
 
 
 namespace BMR {
 
-    InternalFunc void
-    _UpdateWindow(HDC dc,
-                  S32 windowXOffset,
-                  S32 windowYOffset,
-                  S32 windowWidth,
-                  S32 windowHeight) noexcept
-    {
-        StretchDIBits(
-            dc,
-            Inst.XOffset,  Inst.YOffset,  Inst.Pixels.Width, Inst.Pixels.Height,
-            windowXOffset, windowYOffset, windowWidth,       windowHeight,
-            Inst.Pixels.Buffer, &Inst.Info,
-            DIB_RGB_COLORS, SRCCOPY
-        );
+    /*
+     * Rows are padded to cache line, which also keeps every row aligned
+     * for SIMD loads and stores.
+     */
+    constexpr U64
+    _GetPitch(U64 width, PixelFormat format) noexcept
+    {
+        return AlignUp(width * GetBytesPerPixel(format), BMR_CACHE_LINE_SIZE);
     }
 
-
-
     void 
     Init() noexcept {
         Inst.ClearColor = COLOR_BLACK;
-        Inst.CommandQueue.Begin = (U8 *)VirtualAlloc(
-            nullptr, BMR_RENDER_COMMAND_CAPACITY, MEM_COMMIT, PAGE_READWRITE);
+        Inst.LineMode = LineMode::ALIASED;
+        Gamma_Init();
+
+        U32 processors = Thread_GetProcessorCount();
+        Job_Init(processors > 1 ? processors - 1 : 0);
+
+        Inst.CommandQueue.Begin = (U8 *)Memory_Allocate(BMR_RENDER_COMMAND_CAPACITY);
         Inst.CommandQueue.End = Inst.CommandQueue.Begin;
         Inst.CommandCount = 0;
+        Inst.CommandOverflow = 0;
+        Inst.IsOptimizing = true;
+        Inst.Stats = QueueStats{};
+        Inst.IsTileCaching = false;
+        TileCache_Invalidate(&Inst.Tiles);
+        Inst.IsOverdrawing = false;
+        Inst.Overdraw = Overdraw{};
+        Pacing_Reset(&Inst.Pacer);
+        Inst.SampleScale = 1;
+        Inst.Samples = Surface{};
+        Inst.SamplesMemory = VirtualBuffer{};
+        Inst.SampleScratch = VirtualBuffer{};
+        Inst.TransformDepth = 0;
+        Inst.TransformOverflow = 0;
 
-        Inst.BPP = BMR_BPP;
-        Inst.XOffset = 0;
-        Inst.YOffset = 0;
+        Inst.Format = PixelFormat::BGRA8888;
+        Inst.Layout = FrameLayout{PixelFormat::BGRA8888, 0, false};
+        Inst.Palette.Count = 0;
+        Inst.PresentProc = nullptr;
+        Inst.Framebuffer = nullptr;
+        Inst.FramebufferSize = 0;
 
         Inst.Pixels.Buffer = nullptr;
         Inst.Pixels.Width = 0;
         Inst.Pixels.Height = 0;
+        Inst.Pixels.Pitch = 0;
+        Inst.Pixels.Format = Inst.Format;
+        Inst.Pixels.Palette = &Inst.Palette;
+        Inst.Present = Inst.Pixels;
+
+        if (!VirtualBuffer_Reserve(&Inst.PixelsMemory, BMR_FRAMEBUFFER_MAX_SIZE, true)) {
+            Debug_Print("Failed to reserve memory for backbuffer!\n");
+        }
+        Inst.PresentMemory = VirtualBuffer{};
+
+        Inst.Target = &Inst.Pixels;
+        for (Surface &target : Inst.Targets) {
+            target = Surface{};
+        }
     }
 
     void 
     DeInit() noexcept
     { 
-        if (Inst.CommandQueue.Begin != nullptr && VirtualFree(Inst.CommandQueue.Begin, 0, MEM_RELEASE) == 0) {
-            // TODO(ilya.a): Handle memory free error.
+        Memory_Free(Inst.CommandQueue.Begin, BMR_RENDER_COMMAND_CAPACITY);
+        Inst.CommandQueue.Begin = nullptr;
+        Inst.CommandQueue.End   = nullptr;
+
+        VirtualBuffer_Release(&Inst.PixelsMemory);
+        VirtualBuffer_Release(&Inst.PresentMemory);
+        VirtualBuffer_Release(&Inst.SamplesMemory);
+        VirtualBuffer_Release(&Inst.SampleScratch);
+        Inst.Pixels.Buffer = nullptr;
+        Inst.Present.Buffer = nullptr;
+        Inst.Samples.Buffer = nullptr;
+
+        for (Surface &target : Inst.Targets) {
+            DestroyTarget(&target);
+        }
+
+        Overdraw_Release(&Inst.Overdraw);
+        Raster_ReleaseScratch();
+        Job_DeInit();
+    }
+
+    void 
+    BeginDrawing(Surface *target) noexcept 
+    {
+        Inst.Target = target;
+        Inst.TargetCanvas = nullptr;
+        Inst.TransformDepth = 0;
+        Inst.TransformOverflow = 0;
+    }
+
+    void 
+    BeginDrawing(Canvas *canvas) noexcept 
+    {
+        Inst.Target = nullptr;
+        Inst.TargetCanvas = canvas;
+        Inst.TransformDepth = 0;
+        Inst.TransformOverflow = 0;
+    }
+
+    /*
+     * Clips line to range of `U32` coordinates. Returns `false`, if
+     * nothing is left of it.
+     */
+    InternalFunc bool
+    _ClipLine(F64 *x1, F64 *y1, F64 *x2, F64 *y2) noexcept
+    {
+        // NOTE(ilya.a): Liang-Barsky.
+        // [https://en.wikipedia.org/wiki/Liang%E2%80%93Barsky_algorithm]
+        const F64 limit = (F64)MAX_U32;
+        F64 dx = *x2 - *x1, dy = *y2 - *y1;
+        F64 p[4] = { -dx, dx, -dy, dy };
+        F64 q[4] = { *x1, limit - *x1, *y1, limit - *y1 };
+        F64 t0 = 0.0, t1 = 1.0;
+
+        for (U32 i = 0; i < 4; ++i) {
+            if (p[i] == 0.0) {
+                if (q[i] < 0.0) {
+                    return false;
+                }
+                continue;
+            }
+
+            F64 t = q[i] / p[i];
+            if (p[i] < 0.0) {
+                t0 = t > t0 ? t : t0;
+            } else {
+                t1 = t < t1 ? t : t1;
+            }
+        }
+
+        if (t0 > t1) {
+            return false;
+        }
+
+        F64 x0 = *x1, y0 = *y1;
+        *x1 = x0 + t0 * dx;
+        *y1 = y0 + t0 * dy;
+        *x2 = x0 + t1 * dx;
+        *y2 = y0 + t1 * dy;
+        return true;
+    }
+
+    InternalFunc inline U32
+    _RoundToU32(F64 value) noexcept
+    {
+        value = floor(value + 0.5);
+        return value <= 0.0 ? 0 : (value >= (F64)MAX_U32 ? MAX_U32 : (U32)value);
+    }
+
+    /*
+     * Rasterizes single command into `clip` part of `dst`.
+     */
+    InternalFunc void
+    _ExecuteCommand(Surface *dst, const Clip &clip, const U8 *cursor) noexcept
+    {
+        switch (*((const RenderCommandType *)cursor)) {
+            case (RenderCommandType::CLEAR): {
+                auto *command = (const RenderCommand<Color4> *)cursor;
+                Raster_Fill(dst, clip, clip, command->Payload);
+            } break;
+            case (RenderCommandType::LINE): {
+                auto *command = (const RenderCommand<_DrawLine_Payload> *)cursor;
+                const _DrawLine_Payload &p = command->Payload;
+                Raster_Line(dst, clip, p.p1, p.p2, p.Color, p.Mode);
+            } break;
+            case (RenderCommandType::RECT): {
+                auto *command = (const RenderCommand<_DrawRect_Payload> *)cursor;
+                const Rect &rect = command->Payload.Rect;
+                Raster_Fill(
+                    dst, clip, Raster_GetRectClip(rect), command->Payload.Color);
+            } break;
+            case (RenderCommandType::QUAD): {
+                auto *command = (const RenderCommand<_DrawQuad_Payload> *)cursor;
+                const _DrawQuad_Payload &p = command->Payload;
+                Raster_Quad(dst, clip, Raster_GetAffineMap(p.Transform, p.Rect), p.Color);
+            } break;
+            case (RenderCommandType::GRADIENT): {
+                auto *command = (const RenderCommand<Vec2u> *)cursor;
+                Raster_Gradient(dst, clip, command->Payload.X, command->Payload.Y);
+            } break;
+            case (RenderCommandType::LINEAR_GRADIENT):
+            case (RenderCommandType::RADIAL_GRADIENT): {
+                auto *command = (const RenderCommand<_DrawGradient_Payload> *)cursor;
+                const Rect &area = command->Payload.Area;
+                Raster_GradientEx(
+                    dst, clip, Raster_GetRectClip(area), command->Payload.Gradient);
+            } break;
+            case (RenderCommandType::COMPOSITE): {
+                auto *command = (const RenderCommand<_DrawTarget_Payload> *)cursor;
+                const _DrawTarget_Payload &p = command->Payload;
+                Raster_Composite(
+                    dst, clip, p.Target, p.Position.X, p.Position.Y, p.Opacity, p.Mode);
+            } break;
+            case (RenderCommandType::SPRITE): {
+                auto *command = (const RenderCommand<_DrawSprite_Payload> *)cursor;
+                const _DrawSprite_Payload &p = command->Payload;
+                if (p.Target != nullptr) {
+                    Raster_Sprite(
+                        dst, clip, Raster_GetAffineMap(p.Transform, Command_GetSpriteRect(p)),
+                        p.Target, p.Opacity, p.Mode);
+                }
+            } break;
+            case (RenderCommandType::CANVAS): {
+                auto *command = (const RenderCommand<_DrawCanvas_Payload> *)cursor;
+                const _DrawCanvas_Payload &p = command->Payload;
+                Canvas_Present(
+                    dst, clip, p.Source, Raster_GetRectClip(p.Viewport), p.Position.X, p.Position.Y);
+            } break;
+            case (RenderCommandType::BLUR): {
+                auto *command = (const RenderCommand<_Blur_Payload> *)cursor;
+                const _Blur_Payload &p = command->Payload;
+                Raster_Blur(dst, clip, Raster_GetRectClip(p.Area), p.Radius, p.Kind);
+            } break;
+            case (RenderCommandType::DOWNSAMPLE): {
+                auto *command = (const RenderCommand<Rect> *)cursor;
+                Raster_Downsample(dst, clip, Raster_GetRectClip(command->Payload));
+            } break;
+            case (RenderCommandType::NOP):
+            default: {
+            } break;
+        };
+    }
+
+    /*
+     * Matches samples to size of backbuffer. They are released, when
+     * backbuffer isn't supersampled.
+     */
+    InternalFunc void
+    _UpdateSamples() noexcept
+    {
+        Inst.Samples = Surface{};
+
+        if (Inst.SampleScale == 1 || Inst.Pixels.Buffer == nullptr 
+            || Inst.Pixels.Format != PixelFormat::BGRA8888) {
+            VirtualBuffer_Release(&Inst.SamplesMemory);
+            VirtualBuffer_Release(&Inst.SampleScratch);
+            return;
+        }
+
+        if (Inst.SamplesMemory.Base == nullptr 
+            && (!VirtualBuffer_Reserve(&Inst.SamplesMemory, BMR_SAMPLES_MAX_SIZE(Inst.SampleScale), true)
+                || !VirtualBuffer_Reserve(&Inst.SampleScratch, BMR_FRAMEBUFFER_MAX_SIZE, false))) {
+            Debug_Print("Failed to reserve memory for samples!\n");
+            VirtualBuffer_Release(&Inst.SamplesMemory);
+            return;
+        }
+
+        Surface samples = {};
+        samples.Width = Inst.Pixels.Width * Inst.SampleScale;
+        samples.Height = Inst.Pixels.Height * Inst.SampleScale;
+        samples.Pitch = _GetPitch(samples.Width, PixelFormat::BGRA8888);
+        samples.Format = PixelFormat::BGRA8888;
+        samples.Palette = &Inst.Palette;
+
+        if (!VirtualBuffer_Resize(&Inst.SamplesMemory, (Size)samples.Pitch * samples.Height)) {
+            Debug_Print("Failed to allocate memory for samples!\n");
+            return;
+        }
+
+        samples.Buffer = Inst.SamplesMemory.Base;
+        Inst.Samples = samples;
+    }
+
+    constexpr Clip
+    _ScaleClip(const Clip &c, S64 scale) noexcept
+    {
+        return Clip{c.X0 * scale, c.Y0 * scale, c.X1 * scale, c.Y1 * scale};
+    }
+
+    /*
+     * Maps rect to samples. Returns `false`, if scaled transform doesn't
+     * fit into fixed point.
+     */
+    InternalFunc bool
+    _GetSampleMap(const Transform &t, const Rect &r, Out AffineMap *m) noexcept
+    {
+        const S64 s = Inst.SampleScale;
+        const S64 limit = MAX_S32 / s;
+
+        if (t.A > limit || t.A < -limit || t.B > limit || t.B < -limit
+            || t.C > limit || t.C < -limit || t.D > limit || t.D < -limit) {
+            return false;
+        }
+
+        Transform scaled = Transform(
+            (S32)(t.A * s), (S32)(t.B * s), (S32)(t.C * s), (S32)(t.D * s), t.X * s, t.Y * s);
+        *m = Raster_GetAffineMap(scaled, r);
+        return true;
+    }
+
+    /*
+     * Command is rasterized into scratch over `area` of backbuffer, then
+     * each of its pixels is replicated into block of samples.
+     */
+    InternalFunc void
+    _MagnifyCommand(const Clip &hiClip, const Clip &area, const U8 *cursor) noexcept
+    {
+        if (area.IsEmpty()) {
+            return;
+        }
+
+        Surface scratch = {};
+        scratch.Width = area.X1 - area.X0;
+        scratch.Height = area.Y1 - area.Y0;
+        scratch.Pitch = _GetPitch(scratch.Width, PixelFormat::BGRA8888);
+        scratch.Format = PixelFormat::BGRA8888;
+        scratch.Palette = &Inst.Palette;
+        scratch.X = area.X0;
+        scratch.Y = area.Y0;
+
+        if (!VirtualBuffer_Resize(&Inst.SampleScratch, (Size)scratch.Pitch * scratch.Height)) {
+            Debug_Print("Failed to allocate scratch memory for samples!\n");
+            return;
+        }
+        scratch.Buffer = Inst.SampleScratch.Base;
+
+        _ExecuteCommand(&scratch, area, cursor);
+        Raster_Magnify(
+            &Inst.Samples, hiClip, &scratch, area.X0, area.Y0, Inst.SampleScale, MAX_U8, BlendMode::NORMAL);
+    }
+
+    /*
+     * Line is widened into parallel lines, one per sample across it, which
+     * reach far edges of its end pixels.
+     */
+    InternalFunc void
+    _LineSamples(const Clip &hiClip, const _DrawLine_Payload &p) noexcept
+    {
+        const S64 s = Inst.SampleScale;
+        S64 x1 = p.p1.X * s, y1 = p.p1.Y * s, x2 = p.p2.X * s, y2 = p.p2.Y * s;
+        S64 dx = x2 - x1, dy = y2 - y1;
+        bool isSteep = (dx < 0 ? -dx : dx) < (dy < 0 ? -dy : dy);
+
+        S64 *major = isSteep ? (y1 <= y2 ? &y2 : &y1) : (x1 <= x2 ? &x2 : &x1);
+        *major += s - 1;
+
+        for (S64 offset = 0; offset < s; ++offset) {
+            F64 ax = (F64)(x1 + (isSteep ? offset : 0)), ay = (F64)(y1 + (isSteep ? 0 : offset));
+            F64 bx = (F64)(x2 + (isSteep ? offset : 0)), by = (F64)(y2 + (isSteep ? 0 : offset));
+
+            if (!_ClipLine(&ax, &ay, &bx, &by)) {
+                continue;
+            }
+
+            Raster_Line(
+                &Inst.Samples, hiClip, 
+                Vec2u(_RoundToU32(ax), _RoundToU32(ay)), Vec2u(_RoundToU32(bx), _RoundToU32(by)), 
+                p.Color, p.Mode);
+        }
+    }
+
+    /*
+     * Rasterizes queue into samples of `clip` part of backbuffer, then
+     * resolves them. Geometry is scaled to samples, images are replicated.
+     */
+    InternalFunc void
+    _ExecuteSupersampled(const Clip &clip) noexcept
+    {
+        const S64 s = Inst.SampleScale;
+        const Clip hiClip = _ScaleClip(clip, s);
+        Surface *dst = &Inst.Samples;
+
+        const U8 *cursor = Inst.CommandQueue.Begin;
+
+        for (U64 commandIdx = 0; commandIdx < Inst.CommandCount; ++commandIdx) {
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+
+            switch (type) {
+                case (RenderCommandType::CLEAR): {
+                    auto *command = (const RenderCommand<Color4> *)cursor;
+                    Raster_Fill(dst, hiClip, hiClip, command->Payload);
+                } break;
+                case (RenderCommandType::LINE): {
+                    auto *command = (const RenderCommand<_DrawLine_Payload> *)cursor;
+                    _LineSamples(hiClip, command->Payload);
+                } break;
+                case (RenderCommandType::RECT): {
+                    auto *command = (const RenderCommand<_DrawRect_Payload> *)cursor;
+                    Raster_Fill(
+                        dst, hiClip, _ScaleClip(Raster_GetRectClip(command->Payload.Rect), s), 
+                        command->Payload.Color);
+                } break;
+                case (RenderCommandType::QUAD): {
+                    auto *command = (const RenderCommand<_DrawQuad_Payload> *)cursor;
+                    const _DrawQuad_Payload &p = command->Payload;
+                    AffineMap m;
+                    if (_GetSampleMap(p.Transform, p.Rect, &m)) {
+                        Raster_Quad(dst, hiClip, m, p.Color);
+                    } else {
+                        _MagnifyCommand(hiClip, Command_GetBounds(cursor, clip), cursor);
+                    }
+                } break;
+                case (RenderCommandType::SPRITE): {
+                    auto *command = (const RenderCommand<_DrawSprite_Payload> *)cursor;
+                    const _DrawSprite_Payload &p = command->Payload;
+                    AffineMap m;
+                    if (p.Target == nullptr) {
+                        break;
+                    }
+                    if (_GetSampleMap(p.Transform, Command_GetSpriteRect(p), &m)) {
+                        Raster_Sprite(dst, hiClip, m, p.Target, p.Opacity, p.Mode);
+                    } else {
+                        _MagnifyCommand(hiClip, Command_GetBounds(cursor, clip), cursor);
+                    }
+                } break;
+                case (RenderCommandType::LINEAR_GRADIENT):
+                case (RenderCommandType::RADIAL_GRADIENT): {
+                    auto *command = (const RenderCommand<_DrawGradient_Payload> *)cursor;
+                    const _DrawGradient_Payload &p = command->Payload;
+
+                    Gradient g = p.Gradient;
+                    S64 sx = (S64)g.Start.X * s, sy = (S64)g.Start.Y * s;
+                    S64 ex = (S64)g.End.X * s, ey = (S64)g.End.Y * s;
+
+                    if (sx < MIN_S32 || sx > MAX_S32 || sy < MIN_S32 || sy > MAX_S32
+                        || ex < MIN_S32 || ex > MAX_S32 || ey < MIN_S32 || ey > MAX_S32) {
+                        _MagnifyCommand(hiClip, Command_GetBounds(cursor, clip), cursor);
+                        break;
+                    }
+
+                    g.Start = Vec2i((S32)sx, (S32)sy);
+                    g.End = Vec2i((S32)ex, (S32)ey);
+                    Raster_GradientEx(dst, hiClip, _ScaleClip(Raster_GetRectClip(p.Area), s), g);
+                } break;
+                case (RenderCommandType::COMPOSITE): {
+                    auto *command = (const RenderCommand<_DrawTarget_Payload> *)cursor;
+                    const _DrawTarget_Payload &p = command->Payload;
+                    Raster_Magnify(
+                        dst, hiClip, p.Target, p.Position.X, p.Position.Y, (U32)s, p.Opacity, p.Mode);
+                } break;
+                case (RenderCommandType::GRADIENT): {
+                    _MagnifyCommand(hiClip, clip, cursor);
+                } break;
+                case (RenderCommandType::CANVAS): {
+                    auto *command = (const RenderCommand<_DrawCanvas_Payload> *)cursor;
+                    const _DrawCanvas_Payload &p = command->Payload;
+                    if (p.Source == nullptr) {
+                        break;
+                    }
+
+                    // NOTE(ilya.a): Only part of viewport, which is inside
+                    // of canvas, is written.
+                    Clip viewport = Raster_GetRectClip(p.Viewport)
+                        .Intersect(Clip{0, 0, p.Source->Width, p.Source->Height});
+                    S64 dx = (S64)p.Position.X - p.Viewport.X, dy = (S64)p.Position.Y - p.Viewport.Y;
+                    _MagnifyCommand(
+                        hiClip, 
+                        clip.Intersect(Clip{viewport.X0 + dx, viewport.Y0 + dy, viewport.X1 + dx, viewport.Y1 + dy}), 
+                        cursor);
+                } break;
+                case (RenderCommandType::BLUR): {
+                    auto *command = (const RenderCommand<_Blur_Payload> *)cursor;
+                    const _Blur_Payload &p = command->Payload;
+                    U64 radius = (U64)p.Radius * s;
+                    Raster_Blur(
+                        dst, hiClip, _ScaleClip(Raster_GetRectClip(p.Area), s), 
+                        radius < BMR_BLUR_MAX_RADIUS ? (U32)radius : BMR_BLUR_MAX_RADIUS, p.Kind);
+                } break;
+                case (RenderCommandType::DOWNSAMPLE): {
+                    // NOTE(ilya.a): Box filters compose, so it's the same as
+                    // downsampling resolved pixels.
+                    auto *command = (const RenderCommand<Rect> *)cursor;
+                    Raster_Downsample(dst, hiClip, _ScaleClip(Raster_GetRectClip(command->Payload), s));
+                } break;
+                case (RenderCommandType::NOP):
+                default: {
+                } break;
+            }
+
+            cursor += Command_GetSize(type);
+        }
+
+        Raster_Resolve(&Inst.Pixels, clip, &Inst.Samples, (U32)s);
+    }
+
+    /*
+     * Rasterizes queue into `clip` part of `dst`.
+     */
+    InternalFunc void
+    _Execute(Surface *dst, const Clip &clip) noexcept
+    {
+        if (dst == &Inst.Pixels && Inst.Samples.Buffer != nullptr) {
+            _ExecuteSupersampled(clip);
+            return;
+        }
+
+        const U8 *cursor = Inst.CommandQueue.Begin;
+
+        for (U64 commandIdx = 0; commandIdx < Inst.CommandCount; ++commandIdx) {
+            _ExecuteCommand(dst, clip, cursor);
+            cursor += Command_GetSize(*((const RenderCommandType *)cursor));
+        }
+    }
+
+    InternalFunc void
+    _Optimize(const Clip &target) noexcept
+    {
+        if (Inst.IsOptimizing) {
+            Size size = Inst.CommandQueue.End - Inst.CommandQueue.Begin;
+            Inst.CommandCount = Optimize_Commands(
+                Inst.CommandQueue.Begin, &size, Inst.CommandCount, target, &Inst.Stats);
+            Inst.CommandQueue.End = Inst.CommandQueue.Begin + size;
+        } else {
+            Inst.Stats = QueueStats{};
+            Inst.Stats.Submitted = Inst.CommandCount;
+            Inst.Stats.Executed = Inst.CommandCount;
+        }
+    }
+
+    InternalFunc bool
+    _HasPostProcessing(void) noexcept
+    {
+        const U8 *cursor = Inst.CommandQueue.Begin;
+
+        for (U64 commandIdx = 0; commandIdx < Inst.CommandCount; ++commandIdx) {
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            if (type == RenderCommandType::BLUR || type == RenderCommandType::DOWNSAMPLE) {
+                return true;
+            }
+            cursor += Command_GetSize(type);
+        }
+
+        return false;
+    }
+
+    /*
+     * Executes queued commands one by one, each of them touching only
+     * pixels it covers. With tile cache, only tiles of backbuffer, which
+     * changed since previous frame, are touched.
+     */
+    InternalFunc void
+    _Rasterize(Surface *dst) noexcept
+    {
+        if (dst == nullptr || dst->Buffer == nullptr) {
+            return;
+        }
+
+        const Clip clip = Raster_GetSurfaceClip(dst);
+        _Optimize(clip);
+
+        if (Inst.IsOverdrawing) {
+            Overdraw_Count(&Inst.Overdraw, Inst.CommandQueue.Begin, Inst.CommandCount, clip);
+            Overdraw_Resolve(&Inst.Overdraw, dst);
+
+            if (dst == &Inst.Pixels) {
+                TileCache_Invalidate(&Inst.Tiles);
+            }
+            return;
+        }
+
+        if (dst != &Inst.Pixels || !Inst.IsTileCaching) {
+            // NOTE(ilya.a): Hashes no longer describe pixels of backbuffer.
+            if (dst == &Inst.Pixels) {
+                TileCache_Invalidate(&Inst.Tiles);
+            }
+
+            _Execute(dst, clip);
+            return;
+        }
+
+        TileCache *tiles = &Inst.Tiles;
+        Inst.Stats.TilesRasterized = TileCache_Update(
+            tiles, Inst.CommandQueue.Begin, Inst.CommandCount, clip);
+        Inst.Stats.TilesSkipped = tiles->Columns * tiles->Rows - Inst.Stats.TilesRasterized;
+
+        // NOTE(ilya.a): Post-processing reads pixels of neighbouring tiles,
+        // so if anything changed, whole frame is rasterized at once.
+        if (Inst.Stats.TilesRasterized > 0 && _HasPostProcessing()) {
+            Inst.Stats.TilesRasterized = tiles->Columns * tiles->Rows;
+            Inst.Stats.TilesSkipped = 0;
+            _Execute(dst, clip);
+            return;
+        }
+
+        // NOTE(ilya.a): Dirty tiles of a row are rasterized as runs, rows
+        // with same dirty tiles are rasterized at once, so fully dirty
+        // frame is one pass over queue.
+        for (U64 row = 0; row < tiles->Rows;) {
+            const bool *dirty = tiles->IsDirty + row * tiles->Columns;
+
+            U64 rowEnd = row + 1;
+            while (rowEnd < tiles->Rows 
+                   && memcmp(dirty, tiles->IsDirty + rowEnd * tiles->Columns, tiles->Columns) == 0) {
+                rowEnd++;
+            }
+
+            for (U64 column = 0; column < tiles->Columns;) {
+                if (!dirty[column]) {
+                    column++;
+                    continue;
+                }
+
+                U64 columnEnd = column + 1;
+                while (columnEnd < tiles->Columns && dirty[columnEnd]) {
+                    columnEnd++;
+                }
+
+                Clip run = {
+                    clip.X0 + (S64)(column * BMR_TILE_SIZE), 
+                    clip.Y0 + (S64)(row * BMR_TILE_SIZE),
+                    clip.X0 + (S64)(columnEnd * BMR_TILE_SIZE), 
+                    clip.Y0 + (S64)(rowEnd * BMR_TILE_SIZE),
+                };
+                _Execute(dst, clip.Intersect(run));
+
+                column = columnEnd;
+            }
+
+            row = rowEnd;
         }
-        else {
-            Inst.CommandQueue.Begin = nullptr;
-            Inst.CommandQueue.End   = nullptr;
+    }
+
+    /*
+     * Executes command over `area` of canvas. Tiles, which are touched by
+     * area, are committed.
+     */
+    InternalFunc void
+    _ExecuteOnCanvas(Canvas *canvas, const Clip &area, const U8 *command) noexcept
+    {
+        if (area.IsEmpty()) {
+            return;
         }
 
-        if (Inst.Pixels.Buffer != nullptr && VirtualFree(Inst.Pixels.Buffer, 0, MEM_RELEASE) == 0) {
-            // TODO(ilya.a): Handle memory free error.
+        for (S64 y = area.Y0 / BMR_CANVAS_TILE_SIZE; y <= (area.Y1 - 1) / BMR_CANVAS_TILE_SIZE; ++y) {
+            for (S64 x = area.X0 / BMR_CANVAS_TILE_SIZE; x <= (area.X1 - 1) / BMR_CANVAS_TILE_SIZE; ++x) {
+                Surface tile;
+                if (!Canvas_GetTile(canvas, x * BMR_CANVAS_TILE_SIZE, y * BMR_CANVAS_TILE_SIZE, true, &tile)) {
+                    return;
+                }
+
+                _ExecuteCommand(&tile, area.Intersect(Raster_GetSurfaceClip(&tile)), command);
+            }
+        }
+    }
+
+    /*
+     * Line is executed in strips, one tile long along major axis, so only
+     * tiles it's passing through are committed, not its whole bounding box.
+     * Strips don't overlap, so every pixel is still touched once.
+     */
+    InternalFunc void
+    _ExecuteLineOnCanvas(Canvas *canvas, const Clip &bounds, const U8 *command) noexcept
+    {
+        const _DrawLine_Payload &p = ((const RenderCommand<_DrawLine_Payload> *)command)->Payload;
+
+        S64 x0 = p.p1.X, y0 = p.p1.Y, x1 = p.p2.X, y1 = p.p2.Y;
+        S64 dx = x1 - x0, dy = y1 - y0;
+        bool isSteep = (dx < 0 ? -dx : dx) < (dy < 0 ? -dy : dy);
+
+        if (isSteep) {
+            S64 t;
+            t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+        }
+        if (x0 > x1) {
+            S64 t;
+            t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        S64 begin = isSteep ? bounds.Y0 : bounds.X0;
+        S64 end   = isSteep ? bounds.Y1 : bounds.X1;
+        F64 slope = x1 != x0 ? (F64)(y1 - y0) / (F64)(x1 - x0) : 0.0;
+
+        for (S64 m = begin; m < end;) {
+            S64 next = (m / BMR_CANVAS_TILE_SIZE + 1) * BMR_CANVAS_TILE_SIZE;
+            next = next < end ? next : end;
+
+            // NOTE(ilya.a): Minor extent of strip, with a pixel of margin
+            // for rounding and for coverage of antialiased line.
+            S64 a = m < x0 ? x0 : (m > x1 ? x1 : m);
+            S64 b = next - 1 < x0 ? x0 : (next - 1 > x1 ? x1 : next - 1);
+            F64 ya = (F64)y0 + slope * (F64)(a - x0);
+            F64 yb = (F64)y0 + slope * (F64)(b - x0);
+            S64 lo = (S64)floor(ya < yb ? ya : yb) - 1;
+            S64 hi = (S64)ceil(ya < yb ? yb : ya) + 2;
+
+            Clip strip = isSteep ? Clip{lo, m, hi, next} : Clip{m, lo, next, hi};
+            _ExecuteOnCanvas(canvas, bounds.Intersect(strip), command);
+
+            m = next;
+        }
+    }
+
+    /*
+     * Executes queue over canvas. `CLEAR` frees every tile, other commands
+     * commit tiles they cover.
+     */
+    InternalFunc void
+    _RasterizeCanvas(Canvas *canvas) noexcept
+    {
+        const Clip clip = Clip{0, 0, canvas->Width, canvas->Height};
+        _Optimize(clip);
+
+        const U8 *cursor = Inst.CommandQueue.Begin;
+
+        for (U64 commandIdx = 0; commandIdx < Inst.CommandCount; ++commandIdx) {
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            Clip bounds = Command_GetBounds(cursor, clip);
+
+            switch (type) {
+                case (RenderCommandType::CLEAR): {
+                    Canvas_Clear(canvas, ((const RenderCommand<Color4> *)cursor)->Payload);
+                } break;
+                case (RenderCommandType::LINE): {
+                    _ExecuteLineOnCanvas(canvas, bounds, cursor);
+                } break;
+                case (RenderCommandType::GRADIENT):
+                case (RenderCommandType::CANVAS):
+                case (RenderCommandType::BLUR):
+                case (RenderCommandType::DOWNSAMPLE): {
+                    // NOTE(ilya.a): Would commit every tile, read canvas,
+                    // which is written, or read pixels across tiles.
+                } break;
+                default: {
+                    _ExecuteOnCanvas(canvas, bounds, cursor);
+                } break;
+            }
+
+            cursor += Command_GetSize(type);
+        }
+    }
+
+    void 
+    EndDrawing() noexcept
+    {
+        if (Inst.CommandOverflow > 0) {
+            Debug_Print("Render command queue overflowed, frame is refused!\n");
+            DiscardCommands();
+            return;
+        }
+
+        if (Inst.TargetCanvas != nullptr) {
+            _RasterizeCanvas(Inst.TargetCanvas);
         } else {
-            Inst.Pixels.Buffer = nullptr;
+            _Rasterize(Inst.Target);
+        }
+
+        if (Inst.Target == &Inst.Pixels) {
+            if (Inst.Present.Buffer != Inst.Pixels.Buffer) {
+                Format_Convert(&Inst.Pixels, &Inst.Present, Inst.Layout.IsBottomUp);
+            }
+
+            if (Inst.PresentProc != nullptr) {
+                Inst.PresentProc(&Inst.Present);
+            }
+
+            Pacing_MarkPresent(&Inst.Pacer, Time_Now());
         }
+
+        Inst.CommandQueue.End = Inst.CommandQueue.Begin;
+        Inst.CommandCount = 0;
+    }
+
+
+    Surface *
+    GetBackbuffer() noexcept
+    {
+        return &Inst.Pixels;
+    }
+
+    const Surface *
+    GetFrame() noexcept
+    {
+        return &Inst.Present;
     }
 
     void 
-    BeginDrawing(HWND window) noexcept 
+    Backend_SetPresent(PresentProc present) noexcept
     {
-        Inst.Window = window;
+        Inst.PresentProc = present;
     }
 
     void 
-    EndDrawing() noexcept
+    Backend_SetFramebuffer(void *memory, Size size) noexcept
     {
-        Size pitch = Inst.Pixels.Width * Inst.BPP;
-        U8 * row = (U8 *) Inst.Pixels.Buffer;
-
-        for (U64 y = 0; y < Inst.Pixels.Height; ++y) {
-            Color4 *pixel = (Color4 *)row;
-
-            for (U64 x = 0; x < Inst.Pixels.Width; ++x) {
-                Size offset = 0;
-
-                for (U64 commandIdx = 0; commandIdx < Inst.CommandCount; ++commandIdx) {
-                    RenderCommandType type = 
-                        *((RenderCommandType *)(Inst.CommandQueue.Begin + offset));
-
-                    offset += sizeof(RenderCommandType);
-
-                    switch (type) {
-                        case (RenderCommandType::CLEAR): {
-                            Color4 color = *(Color4*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(Color4);
-                            *pixel = color;
-                        } break;
-                        case (RenderCommandType::LINE): {
-                            Vec2u p1 = *(Vec2u*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(Vec2u);
-
-                            Vec2u p2 = *(Vec2u*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(Vec2u);
-
-                        } break;
-                        case (RenderCommandType::RECT): {
-                            Rect rect = *(Rect*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(rect);
-
-                            Color4 color = *(Color4*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(Color4);
-
-                            if (rect.IsInside(x, y)) {
-                                *pixel = color;
-                            }
-                        } break;
-                        case (RenderCommandType::GRADIENT): {
-                            Vec2u v = *(Vec2u*)(Inst.CommandQueue.Begin + offset);
-                            offset += sizeof(Vec2u);
-
-                            *pixel = Color4(x + v.X, y + v.Y, 0);
-                        } break;
-                        case (RenderCommandType::NOP):
-                        default: {
-                            *pixel = Inst.ClearColor;
-                        } break;
-                    };
-                }
-                ++pixel;
+        Inst.Framebuffer = (U8 *)memory;
+        Inst.FramebufferSize = memory != nullptr ? size : 0;
+
+        if (Inst.Pixels.Buffer != nullptr) {
+            Resize(Inst.Pixels.Width, Inst.Pixels.Height);
+        }
+    }
+
+
+    /*
+     * Checks, that commands in `[begin; end)` can be rasterized safely.
+     */
+    InternalFunc bool
+    _ValidateCommands(const U8 *begin, const U8 *end, U64 count) noexcept
+    {
+        const U8 *cursor = begin;
+
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            if ((Size)(end - cursor) < sizeof(RenderCommandType)) {
+                return false;
+            }
+
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            Size size = Command_GetSize(type);
+
+            if (size == 0 || (Size)(end - cursor) < size) {
+                return false;
+            }
+
+            switch (type) {
+                case (RenderCommandType::LINE): {
+                    auto *command = (const RenderCommand<_DrawLine_Payload> *)cursor;
+                    if (command->Payload.Mode != LineMode::ALIASED 
+                        && command->Payload.Mode != LineMode::ANTIALIASED) {
+                        return false;
+                    }
+                } break;
+                case (RenderCommandType::LINEAR_GRADIENT):
+                case (RenderCommandType::RADIAL_GRADIENT): {
+                    auto *command = (const RenderCommand<_DrawGradient_Payload> *)cursor;
+                    const Gradient &gradient = command->Payload.Gradient;
+                    if (gradient.Kind != type 
+                        || gradient.StopCount > BMR_GRADIENT_MAX_STOPS
+                        || (U32)gradient.Spread > (U32)GradientSpread::REFLECT) {
+                        return false;
+                    }
+                } break;
+                case (RenderCommandType::BLUR): {
+                    auto *command = (const RenderCommand<_Blur_Payload> *)cursor;
+                    if (command->Payload.Radius > BMR_BLUR_MAX_RADIUS
+                        || (command->Payload.Kind != BlurKind::BOX 
+                            && command->Payload.Kind != BlurKind::GAUSSIAN)) {
+                        return false;
+                    }
+                } break;
+                case (RenderCommandType::COMPOSITE):
+                case (RenderCommandType::SPRITE):
+                case (RenderCommandType::CANVAS): {
+                    // NOTE(ilya.a): Source is a pointer into the address
+                    // space of whoever pushed the command.
+                    return false;
+                } break;
+                default: {
+                } break;
             }
 
-            row += pitch;
+            cursor += size;
         }
 
-        {
-            // TODO(ilya.a): Check how it's differs with event thing.
-            auto dc = ScopedDC(Inst.Window);
+        return cursor == end;
+    }
 
-            RECT windowRect;
-            GetClientRect(Inst.Window, &windowRect);
-            S32 x = windowRect.left;
-            S32 y = windowRect.top;
-            S32 width = 0, height = 0;
-            GetRectSize(&windowRect, &width, &height);
+    void 
+    GetCommands(Out const void **commands, Out Size *size, Out U64 *count) noexcept
+    {
+        *commands = Inst.CommandQueue.Begin;
+        *size = Inst.CommandQueue.End - Inst.CommandQueue.Begin;
+        *count = Inst.CommandCount;
+    }
 
-            _UpdateWindow(dc.Handle, x, y, width, height);
+    bool 
+    SubmitCommands(const void *commands, Size size, U64 count) noexcept
+    {
+        Size used = Inst.CommandQueue.End - Inst.CommandQueue.Begin;
+        if (used + size > BMR_RENDER_COMMAND_CAPACITY) {
+            Debug_Print("Render command queue is full!\n");
+            return false;
         }
 
+        // NOTE(ilya.a): Validating copy, so commands can't be changed by
+        // sender after the check. Copy starts on record boundary of queue,
+        // so it's aligned, whatever alignment of `commands` is.
+        memcpy(Inst.CommandQueue.End, commands, size);
+
+        if (!_ValidateCommands(Inst.CommandQueue.End, Inst.CommandQueue.End + size, count)) {
+            Debug_Print("Submitted commands are malformed!\n");
+            return false;
+        }
+
+        Inst.CommandQueue.End += size;
+        Inst.CommandCount += count;
+        return true;
+    }
+
+    void 
+    DiscardCommands() noexcept
+    {
         Inst.CommandQueue.End = Inst.CommandQueue.Begin;
         Inst.CommandCount = 0;
+        Inst.CommandOverflow = 0;
+    }
+
+    void 
+    SetQueueOptimization(bool enabled) noexcept
+    {
+        Inst.IsOptimizing = enabled;
     }
 
+    QueueStats 
+    GetQueueStats() noexcept
+    {
+        return Inst.Stats;
+    }
 
     void 
-    Update(HWND window) noexcept 
+    SetTileCache(bool enabled) noexcept
     {
-        PAINTSTRUCT ps = {0};
-        HDC dc = BeginPaint(window, &ps);
+        Inst.IsTileCaching = enabled;
+        TileCache_Invalidate(&Inst.Tiles);
+    }
 
-        if (dc == nullptr) {
-            // TODO(ilya.a): Handle error
-        } else {
-            S32 x = ps.rcPaint.left;
-            S32 y = ps.rcPaint.top;
-            S32 width = 0, height = 0;
-            GetRectSize(&(ps.rcPaint), &width, &height);
-            _UpdateWindow(dc, x, y, width, height);
+    void 
+    InvalidateTiles() noexcept
+    {
+        TileCache_Invalidate(&Inst.Tiles);
+    }
+
+    void 
+    SetOverdrawHeatmap(bool enabled) noexcept
+    {
+        Inst.IsOverdrawing = enabled;
+    }
+
+    bool 
+    IsOverdrawHeatmap() noexcept
+    {
+        return Inst.IsOverdrawing;
+    }
+
+    void 
+    SetSupersampling(Supersampling mode) noexcept
+    {
+        U32 scale = (U32)mode;
+        if (scale != 2 && scale != 4) {
+            scale = 1;
+        }
+
+        if (Inst.SampleScale == scale) {
+            return;
         }
 
-        EndPaint(window, &ps);
+        // NOTE(ilya.a): Samples of previous mode are of no use, and its
+        // reservation may be too small or too big for the new one.
+        Inst.SampleScale = scale;
+        VirtualBuffer_Release(&Inst.SamplesMemory);
+        VirtualBuffer_Release(&Inst.SampleScratch);
+        TileCache_Invalidate(&Inst.Tiles);
+        _UpdateSamples();
+    }
+
+    Supersampling 
+    GetSupersampling() noexcept
+    {
+        return (Supersampling)Inst.SampleScale;
+    }
+
+    OverdrawStats 
+    GetOverdrawStats() noexcept
+    {
+        return Inst.Overdraw.Stats;
+    }
+
+    bool 
+    SaveOverdrawHeatmap(CStr path) noexcept
+    {
+        return Overdraw_Save(&Inst.Overdraw, path);
+    }
+
+    void 
+    SetTargetFrameRate(U32 fps) noexcept
+    {
+        Pacing_SetFrameRate(&Inst.Pacer, fps);
+    }
+
+    void 
+    SetSimulationRate(U32 hz) noexcept
+    {
+        Pacing_SetStepRate(&Inst.Pacer, hz);
+    }
+
+    void 
+    WaitForFrame() noexcept
+    {
+        Pacing_WaitForFrame(&Inst.Pacer);
+    }
+
+    bool 
+    StepSimulation() noexcept
+    {
+        return Pacing_Step(&Inst.Pacer);
+    }
+
+    F32 
+    GetSimulationAlpha() noexcept
+    {
+        return Pacing_GetAlpha(&Inst.Pacer);
+    }
+
+    U64 
+    GetTime() noexcept
+    {
+        return Time_Now();
+    }
+
+    void 
+    MarkInput() noexcept
+    {
+        Pacing_MarkInput(&Inst.Pacer, Time_Now());
+    }
+
+    void 
+    MarkInput(U64 time) noexcept
+    {
+        Pacing_MarkInput(&Inst.Pacer, time);
+    }
+
+    PacingStats 
+    GetPacingStats() noexcept
+    {
+        return Pacing_GetStats(&Inst.Pacer);
     }
 
 
     void 
     Resize(S32 w, S32 h) noexcept
     {
-        if (Inst.Pixels.Buffer != nullptr && VirtualFree(Inst.Pixels.Buffer, 0, MEM_RELEASE) == 0) {
-            //                                                                  ^^^^^^^^^^^
-            // NOTE(ilya.a): Might be more reasonable to use MEM_DECOMMIT instead for 
-            // MEM_RELEASE. Because in that case it's will be keep buffer around, until
-            // we use it again.
-            // P.S. Also will be good to try protect buffer after deallocating or other
-            // stuff.
-            //
-            // TODO(ilya.a): 
-            //     - [ ] Checkout how it works.
-            //     - [ ] Handle allocation error.
-            OutputDebugString("Failed to free backbuffer memory!\n");
+        TileCache_Invalidate(&Inst.Tiles);
+
+        if (w > BMR_FRAMEBUFFER_MAX_WIDTH || h > BMR_FRAMEBUFFER_MAX_HEIGHT) {
+            Debug_Print("Backbuffer size is clamped to the maximum!\n");
+            w = w > BMR_FRAMEBUFFER_MAX_WIDTH  ? BMR_FRAMEBUFFER_MAX_WIDTH  : w;
+            h = h > BMR_FRAMEBUFFER_MAX_HEIGHT ? BMR_FRAMEBUFFER_MAX_HEIGHT : h;
+        }
+
+        if (Inst.Format == PixelFormat::INDEXED8 && Inst.Palette.Count == 0) {
+            Palette_BuildDefault(&Inst.Palette);
         }
+
         Inst.Pixels.Width = w;
         Inst.Pixels.Height = h;
+        Inst.Pixels.Pitch = _GetPitch(w, Inst.Format);
+        Inst.Pixels.Format = Inst.Format;
+        Inst.Pixels.Palette = &Inst.Palette;
+
+        const FrameLayout &layout = Inst.Layout;
+        U64 framePitch = _GetPitch(w, layout.Format);
+        if (layout.Pitch != 0 && layout.Pitch < (U64)w * GetBytesPerPixel(layout.Format)) {
+            Debug_Print("Pitch of frame is less than its width, rows are padded instead!\n");
+        } else if (layout.Pitch != 0) {
+            framePitch = layout.Pitch;
+        }
+
+        // NOTE(ilya.a): Frame, which is presented, is placed right into
+        // memory of window backend, so nothing is copied before present.
+        // Backbuffer itself is the frame, if it's in the same layout.
+        bool shared = Inst.Framebuffer != nullptr 
+            && (Size)framePitch * h <= Inst.FramebufferSize;
+        bool isFrame = Inst.Format == layout.Format && !layout.IsBottomUp 
+            && framePitch == Inst.Pixels.Pitch;
+
+        if (shared && isFrame) {
+            Inst.Pixels.Buffer = Inst.Framebuffer;
+            VirtualBuffer_Resize(&Inst.PixelsMemory, 0);
+        } else {
+            // NOTE(ilya.a): Memory is committed in place of previous backbuffer,
+            // so resize is only touching page tables, when size grows.
+            Inst.Pixels.Buffer = Inst.PixelsMemory.Base;
+            if (!VirtualBuffer_Resize(&Inst.PixelsMemory, (Size)Inst.Pixels.Pitch * h)) {
+                // TODO:(ilya.a): Check for errors.
+                Debug_Print("Failed to allocate memory for backbuffer!\n");
+                Inst.Pixels.Buffer = nullptr;
+            }
+        }
+
+        Inst.Present = Inst.Pixels;
+        if (!isFrame) {
+            Inst.Present.Format = layout.Format;
+            Inst.Present.Pitch = framePitch;
+
+            if (shared) {
+                Inst.Present.Buffer = Inst.Framebuffer;
+                VirtualBuffer_Release(&Inst.PresentMemory);
+            } else {
+                if (Inst.PresentMemory.Base == nullptr 
+                    && !VirtualBuffer_Reserve(&Inst.PresentMemory, BMR_FRAMEBUFFER_MAX_SIZE, true)) {
+                    Debug_Print("Failed to reserve memory for present buffer!\n");
+                }
+
+                Inst.Present.Buffer = Inst.PresentMemory.Base;
+
+                if (!VirtualBuffer_Resize(&Inst.PresentMemory, (Size)Inst.Present.Pitch * h)) {
+                    Debug_Print("Failed to allocate memory for present buffer!\n");
+                    Inst.Present.Buffer = nullptr;
+                }
+            }
+        } else if (Inst.PresentMemory.Base != nullptr) {
+            VirtualBuffer_Release(&Inst.PresentMemory);
+        }
+
+        _UpdateSamples();
+    }
+
+    void 
+    SetPixelFormat(PixelFormat format) noexcept
+    {
+        if (Inst.Format == format) {
+            return;
+        }
+
+        Inst.Format = format;
+        if (Inst.Pixels.Buffer != nullptr) {
+            Resize(Inst.Pixels.Width, Inst.Pixels.Height);
+        }
+    }
+
+    bool 
+    SetFrameLayout(const FrameLayout &layout) noexcept
+    {
+        if ((layout.Format != PixelFormat::BGRA8888 && layout.Format != PixelFormat::RGBA8888)
+            || layout.Pitch % 4 != 0) {
+            Debug_Print("Frame layout is not supported!\n");
+            return false;
+        }
+
+        Inst.Layout = layout;
+        if (Inst.Pixels.Buffer != nullptr) {
+            Resize(Inst.Pixels.Width, Inst.Pixels.Height);
+        }
+        return true;
+    }
+
+    FrameLayout 
+    GetFrameLayout() noexcept
+    {
+        return Inst.Layout;
+    }
+
+    void 
+    SetPalette(const Color4 *colors, U32 count) noexcept
+    {
+        Palette_Build(&Inst.Palette, colors, count);
+        TileCache_Invalidate(&Inst.Tiles);
+    }
+
+
+    Surface *
+    CreateTarget(U32 w, U32 h, PixelFormat format) noexcept
+    {
+        if (format == PixelFormat::INDEXED8 && Inst.Palette.Count == 0) {
+            Palette_BuildDefault(&Inst.Palette);
+        }
+
+        for (Surface &target : Inst.Targets) {
+            if (target.Buffer != nullptr) {
+                continue;
+            }
+
+            U64 pitch = _GetPitch(w, format);
+            target.Buffer = Memory_Allocate((Size)pitch * h);
+
+            if (target.Buffer == nullptr) {
+                Debug_Print("Failed to allocate memory for render target!\n");
+                return nullptr;
+            }
+
+            target.Width = w;
+            target.Height = h;
+            target.Pitch = pitch;
+            target.Format = format;
+            target.Palette = &Inst.Palette;
+            return &target;
+        }
+
+        Debug_Print("Out of render target slots!\n");
+        return nullptr;
+    }
+
+    void 
+    DestroyTarget(Surface *target) noexcept
+    {
+        if (target == nullptr || target->Buffer == nullptr) {
+            return;
+        }
+
+        if (Inst.Target == target) {
+            Inst.Target = &Inst.Pixels;
+        }
+
+        Memory_Free(target->Buffer, (Size)target->Pitch * target->Height);
+        *target = Surface{};
+    }
+
+    Canvas *
+    CreateCanvas(U32 w, U32 h, const Color4 &background) noexcept
+    {
+        return Canvas_Create(w, h, background);
+    }
 
-        Inst.Info.bmiHeader.biSize          = sizeof(Inst.Info.bmiHeader);
-        Inst.Info.bmiHeader.biWidth         = w;
-        Inst.Info.bmiHeader.biHeight        = h;
-        Inst.Info.bmiHeader.biPlanes        = 1;
-        Inst.Info.bmiHeader.biBitCount      = 32;      // NOTE: Align to WORD
-        Inst.Info.bmiHeader.biCompression   = BI_RGB;
-        Inst.Info.bmiHeader.biSizeImage     = 0;
-        Inst.Info.bmiHeader.biXPelsPerMeter = 0;
-        Inst.Info.bmiHeader.biYPelsPerMeter = 0;
-        Inst.Info.bmiHeader.biClrUsed       = 0;
-        Inst.Info.bmiHeader.biClrImportant  = 0;
+    void 
+    DestroyCanvas(Canvas *canvas) noexcept
+    {
+        if (Inst.TargetCanvas == canvas) {
+            Inst.TargetCanvas = nullptr;
+            Inst.Target = &Inst.Pixels;
+        }
 
-        Size bufferSize = w * h * Inst.BPP;
-        Inst.Pixels.Buffer = 
-            VirtualAlloc(nullptr, bufferSize, MEM_COMMIT, PAGE_READWRITE);
+        Canvas_Destroy(canvas);
+    }
 
-        if (Inst.Pixels.Buffer == nullptr) {
-            // TODO:(ilya.a): Check for errors.
-            OutputDebugString("Failed to allocate memory for backbuffer!\n");
+    Size 
+    GetCanvasMemory(const Canvas *canvas) noexcept
+    {
+        if (canvas == nullptr) {
+            return 0;
         }
+
+        return sizeof(Canvas) 
+            + canvas->ChunkCount * sizeof(CanvasChunk) 
+            + canvas->TileCount * BMR_CANVAS_TILE_BYTES;
+    }
+
+
+    Asset *
+    LoadAsset(CStr path) noexcept
+    {
+        return Asset_Load(path);
+    }
+
+    U64
+    LoadAssets(const CStr *paths, U64 count, Out Asset **assets) noexcept
+    {
+        return Asset_LoadBatch(paths, count, assets);
+    }
+
+    void
+    DestroyAsset(Asset *asset) noexcept
+    {
+        Asset_Destroy(asset);
+    }
+
+    Surface *
+    GetAssetSurface(Asset *asset) noexcept
+    {
+        return &asset->Pixels;
     }
 
 
@@ -256,8 +1379,26 @@ namespace BMR {
     template<typename T> InternalFunc void 
     _PushRenderCommand(RenderCommandType type, const T &payload) noexcept
     {
-        *(RenderCommand<T> *)Inst.CommandQueue.End = RenderCommand<T>(type, payload);
-        Inst.CommandQueue.End += sizeof(RenderCommand<T>);
+        static_assert(alignof(RenderCommand<T>) <= BMR_COMMAND_ALIGNMENT);
+        constexpr Size size = Command_GetRecordSize(sizeof(RenderCommand<T>));
+
+        Size used = Inst.CommandQueue.End - Inst.CommandQueue.Begin;
+        if (used + size > BMR_RENDER_COMMAND_CAPACITY) {
+            if (Inst.CommandOverflow == 0) {
+                Debug_Print("Render command queue is full!\n");
+            }
+            Inst.CommandOverflow++;
+            return;
+        }
+
+        // NOTE(ilya.a): Members are written into zeroed record, so padding
+        // between type and payload, and after payload, is zero too. See
+        // `_HashCommand`.
+        memset(Inst.CommandQueue.End, 0, size);
+        auto *command = (RenderCommand<T> *)Inst.CommandQueue.End;
+        command->Type = type;
+        command->Payload = payload;
+        Inst.CommandQueue.End += size;
 
         Inst.CommandCount++;
     }
@@ -269,6 +1410,43 @@ namespace BMR {
     }
 
 
+    InternalFunc const Transform &
+    _GetTransform() noexcept
+    {
+        PersistVar constexpr Transform identity = Transform();
+        return Inst.TransformDepth > 0 ? Inst.Transforms[Inst.TransformDepth - 1] : identity;
+    }
+
+    void
+    PushTransform(const Transform &t) noexcept
+    {
+        if (Inst.TransformDepth == BMR_TRANSFORM_STACK_DEPTH) {
+            Debug_Print("Transform stack is full!\n");
+            Inst.TransformOverflow++;
+            return;
+        }
+
+        Inst.Transforms[Inst.TransformDepth] = _GetTransform() * t;
+        Inst.TransformDepth++;
+    }
+
+    void
+    PopTransform() noexcept
+    {
+        if (Inst.TransformOverflow > 0) {
+            Inst.TransformOverflow--;
+        } else if (Inst.TransformDepth > 0) {
+            Inst.TransformDepth--;
+        }
+    }
+
+    InternalFunc void
+    _MapPoint(const Transform &t, F64 x, F64 y, Out F64 *mx, Out F64 *my) noexcept
+    {
+        *mx = ((F64)t.A * x + (F64)t.B * y + (F64)t.X) / BMR_FIXED_ONE;
+        *my = ((F64)t.C * x + (F64)t.D * y + (F64)t.Y) / BMR_FIXED_ONE;
+    }
+
     void 
     Clear() noexcept 
     {
@@ -278,41 +1456,98 @@ namespace BMR {
         );
     }
 
-    struct _DrawLine_Payload {
-        Vec2u p1;
-        Vec2u p2;
-    };
+    void 
+    SetLineMode(LineMode mode) noexcept 
+    {
+        Inst.LineMode = mode;
+    }
 
     void 
-    DrawLine(U32 x1, U32 y1, U32 x2, U32 y2) noexcept
+    DrawLine(U32 x1, U32 y1, U32 x2, U32 y2, const Color4 &c) noexcept
     {
-        _PushRenderCommand(
-            RenderCommandType::LINE, 
-            _DrawLine_Payload{Vec2u(x1, y1), Vec2u(x2, y2)}
-        );
+        DrawLine(Vec2u(x1, y1), Vec2u(x2, y2), c);
     }
 
 
     void
-    DrawLine(Vec2u p1, Vec2u p2) noexcept
+    DrawLine(Vec2u p1, Vec2u p2, const Color4 &c) noexcept
     {
+        const Transform &t = _GetTransform();
+
+        if (!t.IsIdentity()) {
+            F64 x1, y1, x2, y2;
+            _MapPoint(t, p1.X, p1.Y, &x1, &y1);
+            _MapPoint(t, p2.X, p2.Y, &x2, &y2);
+
+            if (!_ClipLine(&x1, &y1, &x2, &y2)) {
+                return;
+            }
+
+            p1 = Vec2u(_RoundToU32(x1), _RoundToU32(y1));
+            p2 = Vec2u(_RoundToU32(x2), _RoundToU32(y2));
+        }
+
         _PushRenderCommand(
             RenderCommandType::LINE, 
-            _DrawLine_Payload{p1, p2}
+            _DrawLine_Payload{p1, p2, c, Inst.LineMode}
         );
     }
 
-    struct _DrawRect_Payload {
-        Rect Rect;
-        Color4 Color;
-    };
+    InternalFunc void
+    _PushQuad(const Rect &r, const Color4 &c, const Transform &t) noexcept
+    {
+        _DrawQuad_Payload payload = {};
+        payload.Rect = r;
+        payload.Color = c;
+        payload.Transform = t;
+
+        _PushRenderCommand(RenderCommandType::QUAD, payload);
+    }
 
     void 
     DrawRect(const Rect &r, const Color4 &c) noexcept 
     {
+        const Transform &t = _GetTransform();
+
+        if (t.IsIdentity()) {
+            _PushRenderCommand(
+                RenderCommandType::RECT, 
+                _DrawRect_Payload{r, c}
+            );
+            return;
+        }
+
+        if (!t.IsAxisAligned()) {
+            _PushQuad(r, c, t);
+            return;
+        }
+
+        // NOTE(ilya.a): Pixels, which centers are inside of mapped rect, the
+        // same ones `QUAD` would cover.
+        F64 x0, y0, x1, y1;
+        _MapPoint(t, r.X, r.Y, &x0, &y0);
+        _MapPoint(t, (F64)r.X + r.Width, (F64)r.Y + r.Height, &x1, &y1);
+
+        F64 minX = x0 < x1 ? x0 : x1, maxX = x0 < x1 ? x1 : x0;
+        F64 minY = y0 < y1 ? y0 : y1, maxY = y0 < y1 ? y1 : y0;
+
+        // NOTE(ilya.a): Samples cover fractions of pixel, so edges, which
+        // aren't on pixel boundary, are left to quad.
+        if (Inst.SampleScale > 1 
+            && (minX != floor(minX) || maxX != floor(maxX) || minY != floor(minY) || maxY != floor(maxY))) {
+            _PushQuad(r, c, t);
+            return;
+        }
+
+        U32 left = _RoundToU32(ceil(minX - 0.5)), right = _RoundToU32(ceil(maxX - 0.5));
+        U32 top = _RoundToU32(ceil(minY - 0.5)), bottom = _RoundToU32(ceil(maxY - 0.5));
+        if (left >= right || top >= bottom) {
+            return;
+        }
+
         _PushRenderCommand(
             RenderCommandType::RECT, 
-            _DrawRect_Payload{r, c}
+            _DrawRect_Payload{Rect(left, top, right - left, bottom - top), c}
         );
     }
 
@@ -321,10 +1556,7 @@ namespace BMR {
              U32 w, U32 h, 
              const Color4 &c) noexcept 
     {
-        _PushRenderCommand(
-            RenderCommandType::RECT, 
-            _DrawRect_Payload{Rect(x, y, w, h), c}
-        );
+        DrawRect(Rect(x, y, w, h), c);
     }
 
     void 
@@ -345,5 +1577,115 @@ namespace BMR {
         );
     }
 
+    InternalFunc void
+    _PushGradient(RenderCommandType kind, const Rect &area, 
+                  Vec2i start, Vec2i end, 
+                  const GradientStop *stops, U32 count, 
+                  GradientSpread spread) noexcept
+    {
+        _DrawGradient_Payload payload = {};
+        payload.Area = area;
+        payload.Gradient.Kind = kind;
+        payload.Gradient.Spread = spread;
+        payload.Gradient.Start = start;
+        payload.Gradient.End = end;
+        payload.Gradient.StopCount = count < BMR_GRADIENT_MAX_STOPS ? count : BMR_GRADIENT_MAX_STOPS;
+
+        for (U32 i = 0; i < payload.Gradient.StopCount; ++i) {
+            payload.Gradient.Stops[i] = stops[i];
+        }
+
+        _PushRenderCommand(kind, payload);
+    }
+
+    void 
+    DrawLinearGradient(const Rect &area, Vec2i start, Vec2i end, 
+                       const GradientStop *stops, U32 count, 
+                       GradientSpread spread) noexcept 
+    {
+        _PushGradient(
+            RenderCommandType::LINEAR_GRADIENT, area, start, end, stops, count, spread);
+    }
+
+    void 
+    DrawRadialGradient(const Rect &area, Vec2i center, U32 radius, 
+                       const GradientStop *stops, U32 count, 
+                       GradientSpread spread) noexcept 
+    {
+        _PushGradient(
+            RenderCommandType::RADIAL_GRADIENT, area, 
+            center, Vec2i(center.X + (S32)radius, center.Y), stops, count, spread);
+    }
+
+    void 
+    DrawTarget(const Surface *target, U32 x, U32 y, 
+               U8 opacity, BlendMode mode) noexcept 
+    {
+        DrawTarget(target, Vec2u(x, y), opacity, mode);
+    }
+
+    void 
+    DrawTarget(const Surface *target, Vec2u position, 
+               U8 opacity, BlendMode mode) noexcept 
+    {
+        const Transform &t = _GetTransform();
+
+        if (!t.IsIdentity()) {
+            F64 x, y;
+            _MapPoint(t, position.X, position.Y, &x, &y);
+
+            bool isMoved = t.A == BMR_FIXED_ONE && t.B == 0 && t.C == 0 && t.D == BMR_FIXED_ONE;
+            if (!isMoved || floor(x + 0.5) < 0.0 || floor(y + 0.5) < 0.0
+                || floor(x + 0.5) > (F64)MAX_U32 || floor(y + 0.5) > (F64)MAX_U32) {
+                _DrawSprite_Payload payload = {};
+                payload.Target = target;
+                payload.Position = position;
+                payload.Opacity = opacity;
+                payload.Mode = mode;
+                payload.Transform = t;
+
+                _PushRenderCommand(RenderCommandType::SPRITE, payload);
+                return;
+            }
+
+            position = Vec2u(_RoundToU32(x), _RoundToU32(y));
+        }
+
+        _DrawTarget_Payload payload = {};
+        payload.Target = target;
+        payload.Position = position;
+        payload.Opacity = opacity;
+        payload.Mode = mode;
+
+        _PushRenderCommand(RenderCommandType::COMPOSITE, payload);
+    }
+
+    void 
+    DrawCanvas(const Canvas *canvas, const Rect &viewport, U32 x, U32 y) noexcept
+    {
+        _PushRenderCommand(
+            RenderCommandType::CANVAS, 
+            _DrawCanvas_Payload{canvas, viewport, Vec2u(x, y)}
+        );
+    }
+
+    void 
+    Blur(const Rect &area, U32 radius, BlurKind kind) noexcept
+    {
+        // NOTE(ilya.a): Box filter is O(radius) per line, and its channel
+        // sums overflow for huge radii.
+        if (radius > BMR_BLUR_MAX_RADIUS) {
+            radius = BMR_BLUR_MAX_RADIUS;
+        }
+
+        _PushRenderCommand(RenderCommandType::BLUR, _Blur_Payload{area, radius, kind});
+    }
+
+    void 
+    Downsample(const Rect &area) noexcept
+    {
+        _PushRenderCommand(RenderCommandType::DOWNSAMPLE, area);
+    }
+
 
 };  // namespace BMR
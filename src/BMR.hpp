@@ -11,14 +11,34 @@
 #ifndef SBMR_BMR_HPP_INCLUDED
 #define SBMR_BMR_HPP_INCLUDED
 
+#if defined(_WIN32)
+    #include <Windows.h>
+#endif
+
 #include "Types.hpp"
+#include "Macros.hpp"
 #include "Coloring.hpp"
 #include "Lin.hpp"
 #include "Geom.hpp"
+#include "Surface.hpp"
+
+
+#define BMR_GRADIENT_MAX_STOPS 8
+#define BMR_RENDER_COMMAND_CAPACITY (64 * 1024)  // NOTE(ilya.a): In bytes.
+
+#define BMR_FRAMEBUFFER_MAX_WIDTH  7680
+#define BMR_FRAMEBUFFER_MAX_HEIGHT 4320
+
+#define BMR_CANVAS_MAX_SIZE (1 << 20)
 
+#define BMR_BLUR_MAX_RADIUS 1024
+
+#define BMR_OVERDRAW_MAX_SHADE 8
+
+#define BMR_TRANSFORM_STACK_DEPTH 32
+
+#define BMR_ASSET_MAX_SIZE 16384
 
-// TODO(ilya.a): Parametrize it, if will be neccesery to change bytes per pixel
-#define BMR_BPP 4
 
 namespace BMR {
 
@@ -28,7 +48,64 @@ namespace BMR {
 
 	    LINE     = 10,
 	    RECT     = 11,
-	    GRADIENT = 20,
+	    QUAD     = 12,  // NOTE(ilya.a): Transformed rect.
+	    GRADIENT        = 20,
+	    LINEAR_GRADIENT = 21,
+	    RADIAL_GRADIENT = 22,
+
+	    COMPOSITE = 30,
+	    CANVAS    = 31,
+	    SPRITE    = 32,  // NOTE(ilya.a): Transformed target.
+
+	    BLUR       = 40,
+	    DOWNSAMPLE = 41,
+	};
+
+
+	/*
+	 * What happens with gradient outside of `[0; 1]` range.
+	 */
+	enum class GradientSpread {
+	    CLAMP   = 0,  // Extends first and last colors.
+	    REPEAT  = 1,
+	    REFLECT = 2,
+	};
+
+	struct GradientStop {
+	    F32    Offset;  // NOTE(ilya.a): In range `[0; 1]`, ascending.
+	    Color4 Color;
+	};
+
+	struct Gradient {
+	    RenderCommandType Kind;  // NOTE(ilya.a): `LINEAR_GRADIENT` or `RADIAL_GRADIENT`.
+	    GradientSpread    Spread;
+	    Vec2i             Start;   // NOTE(ilya.a): Center of radial gradient.
+	    Vec2i             End;     // NOTE(ilya.a): Radial gradient ends on circle through it.
+	    U32               StopCount;
+	    GradientStop      Stops[BMR_GRADIENT_MAX_STOPS];
+	};
+
+
+	enum class LineMode {
+	    ALIASED     = 0,
+	    ANTIALIASED = 1,  // Blended by coverage in linear light.
+	};
+
+
+	enum class BlurKind {
+	    BOX      = 0,
+	    GAUSSIAN = 1,  // Approximated by three box passes.
+	};
+
+	/*
+	 * How pixels of render target are combined with pixels beneath it.
+	 * Each mode is scaled by opacity of the composite.
+	 */
+	enum class BlendMode {
+	    NORMAL   = 0,  // Replaces pixels, ignoring alpha channel.
+	    ALPHA    = 1,  // Blends by alpha channel of target.
+	    ADD      = 2,
+	    MULTIPLY = 3,
 	};
 
 
@@ -48,18 +125,307 @@ namespace BMR {
 	void Init() noexcept;
 	void DeInit() noexcept;
 
-	void Update(HWND window) noexcept;
 	void Resize(S32 w, S32 h) noexcept;
 
+#if defined(_WIN32)
+	void Update(HWND window) noexcept;
     void BeginDrawing(HWND window) noexcept;
+#endif
+
+    void BeginDrawing(Surface *target) noexcept;
+
+	/*
+	 * Rasterizes queued commands and presents them. If any command didn't
+	 * fit into the queue, frame is refused and target is left as it was.
+	 */
 	void EndDrawing() noexcept;
 
+	/*
+	 * Surface, which commands are rasterized into between `BeginDrawing`
+	 * and `EndDrawing`, when no other target is given.
+	 */
+	Surface *GetBackbuffer() noexcept;
+
+	/*
+	 * Last finished frame, in layout of `SetFrameLayout`.
+	 */
+	const Surface *GetFrame() noexcept;
+
+	/*
+	 * Memory layout of frame, which is presented and returned by
+	 * `GetFrame`. Default one is `BGRA8888`, top-down, with rows padded
+	 * to cache line, which is the backbuffer itself, so it's never copied.
+	 * Other layouts, e.g. `RGBA8888` or bottom-up for video encoders, or
+	 * packed rows for GPU upload, are converted once per frame: rows are
+	 * copied, flipped or swizzled only where layout differs.
+	 *
+	 * Rows of bottom-up frame are stored from the last one, so row `y` of
+	 * frame surface is row `Height - 1 - y` of image. GDI backend presents
+	 * any layout, X11 backend presents only top-down `BGRA8888`.
+	 */
+	struct FrameLayout {
+	    PixelFormat Format;      // NOTE(ilya.a): `BGRA8888` or `RGBA8888`.
+	    U64         Pitch;       // NOTE(ilya.a): Multiple of 4, zero for rows padded to cache line.
+	    bool        IsBottomUp;
+	};
+
+	/*
+	 * Returns `false`, if layout isn't supported. Pitch, which is less
+	 * than width of frame, is padded to cache line instead.
+	 */
+	bool SetFrameLayout(const FrameLayout &layout) noexcept;
+	FrameLayout GetFrameLayout() noexcept;
+
+	/*
+	 * Serialized command queue.
+	 *
+	 * Commands, which were pushed since last `EndDrawing`, can be taken
+	 * out of the process and appended to the queue of another instance.
+	 * Submitted commands are validated, `COMPOSITE`, `SPRITE` and `CANVAS`
+	 * are rejected, because they are referencing their source by pointer.
+	 */
+	void GetCommands(Out const void **commands, Out Size *size, Out U64 *count) noexcept;
+	bool SubmitCommands(const void *commands, Size size, U64 count) noexcept;
+	void DiscardCommands() noexcept;
+
+	/*
+	 * What queue optimizer and tile cache did with the last rasterized
+	 * queue. Pixels are estimate of raster work: covered area of fills,
+	 * length of lines.
+	 */
+	struct QueueStats {
+	    U64 Submitted;
+	    U64 Executed;
+	    U64 Overdrawn;  // NOTE(ilya.a): Dropped before the last full clear.
+	    U64 Culled;     // NOTE(ilya.a): Zero area or outside of target.
+	    U64 Merged;     // NOTE(ilya.a): Rects merged into previous one.
+	    U64 Reordered;  // NOTE(ilya.a): Moved, when grouped by type.
+
+	    U64 PixelsSubmitted;
+	    U64 PixelsExecuted;
+
+	    U64 TilesRasterized;
+	    U64 TilesSkipped;
+	};
+
+	/*
+	 * Queue is optimized before rasterization by default. Result is the
+	 * same, only less pixels are touched.
+	 */
+	void SetQueueOptimization(bool enabled) noexcept;
+	QueueStats GetQueueStats() noexcept;
+
+	/*
+	 * Tile cache of backbuffer, disabled by default. Each frame must redraw
+	 * the whole scene (e.g. start with `Clear`), then tiles, commands of
+	 * which are the same as in previous frame, are not rasterized again.
+	 *
+	 * Backbuffer must be changed only by commands, while it's enabled, or
+	 * `InvalidateTiles` must be called after.
+	 */
+	void SetTileCache(bool enabled) noexcept;
+	void InvalidateTiles() noexcept;
+
+	/*
+	 * Overdraw heatmap, disabled by default. While it's enabled, commands
+	 * aren't rasterized, each pixel of frame is shaded by number of
+	 * commands, which wrote it instead: black for none, then blue, green,
+	 * yellow, red and white for `BMR_OVERDRAW_MAX_SHADE` or more. Targets,
+	 * which are drawn meanwhile, get heatmap too.
+	 *
+	 * Commands are counted after queue optimization, so heatmap shows
+	 * what is actually rasterized. Stats and `SaveOverdrawHeatmap` are
+	 * about the last frame, which was drawn with heatmap enabled.
+	 */
+	struct OverdrawStats {
+	    U64 Pixels;          // NOTE(ilya.a): Of the frame.
+	    U64 PixelsWritten;   // NOTE(ilya.a): Sum of writes over every pixel.
+	    U64 PixelsCovered;   // NOTE(ilya.a): Written at least once.
+	    U32 MaxOverdraw;
+	    F32 AverageOverdraw; // NOTE(ilya.a): Writes per covered pixel.
+
+	    // NOTE(ilya.a): Writes by kind of command.
+	    U64 ClearPixels;
+	    U64 LinePixels;
+	    U64 RectPixels;
+	    U64 GradientPixels;
+	    U64 CompositePixels;
+	    U64 CanvasPixels;
+	    U64 PostProcessPixels;
+	};
+
+	void SetOverdrawHeatmap(bool enabled) noexcept;
+	bool IsOverdrawHeatmap() noexcept;
+	OverdrawStats GetOverdrawStats() noexcept;
+
+	/*
+	 * Writes heatmap of the last frame as 32-bit BMP file, so it can be
+	 * taken without window.
+	 */
+	bool SaveOverdrawHeatmap(CStr path) noexcept;
+
+	/*
+	 * Ordered grid supersampling of backbuffer, disabled by default. Frame
+	 * is rasterized with 2x2 or 4x4 samples per pixel, then each pixel is
+	 * the average of its samples, so edges of rects, quads, sprites and
+	 * lines are antialiased. Samples are averaged as they are stored, not
+	 * in linear light, which keeps resolve as fast as memory allows.
+	 *
+	 * Commands, which aren't geometry (`DrawGrad`, `DrawTarget` at whole
+	 * pixel, `DrawCanvas`), give the same pixels as without it. Only
+	 * `BGRA8888` backbuffer is supersampled, targets and canvases never
+	 * are, and neither is overdraw heatmap. Mode is the number of samples
+	 * along each axis.
+	 */
+	enum class Supersampling {
+	    NONE     = 1,
+	    GRID_2X2 = 2,
+	    GRID_4X4 = 4,
+	};
+
+	void SetSupersampling(Supersampling mode) noexcept;
+	Supersampling GetSupersampling() noexcept;
+
+	/*
+	 * Frame pacing. Main loop is expected to look like this:
+	 *
+	 *   WaitForFrame();
+	 *   (poll events, calling MarkInput() for each input)
+	 *   while (StepSimulation()) { (update) }
+	 *   BeginDrawing(...); (render) EndDrawing();
+	 *
+	 * `WaitForFrame` sleeps until the next frame is due, the last bit of
+	 * wait is spun, since sleep wakes up late. Frame rate isn't capped by
+	 * default. Simulation is stepped once per frame by default, with
+	 * `SetSimulationRate` it's stepped at fixed rate out of elapsed time.
+	 *
+	 * Time is in nanoseconds of `GetTime`. Latency is time from the
+	 * earliest input, which was marked before present of backbuffer,
+	 * till that present. Percentiles are over the latest samples.
+	 */
+	struct PacingStats {
+	    U64 Frames;
+	    U64 FrameTimeP50;
+	    U64 FrameTimeP99;
+
+	    U64 Inputs;       // NOTE(ilya.a): Presented ones.
+	    U64 LatencyLast;
+	    U64 LatencyP50;
+	    U64 LatencyP90;
+	    U64 LatencyP99;
+	    U64 LatencyMax;
+	    U64 LastPresent;
+
+	    U64 SleepTime;    // NOTE(ilya.a): Spent in `WaitForFrame` in total.
+	    U64 SpinTime;
+	};
+
+	void SetTargetFrameRate(U32 fps) noexcept;  // NOTE(ilya.a): Zero for uncapped.
+	void SetSimulationRate(U32 hz) noexcept;    // NOTE(ilya.a): Zero for once per frame.
+
+	void WaitForFrame() noexcept;
+	bool StepSimulation() noexcept;
+
+	/*
+	 * Fraction of simulation step, which is accumulated, but not yet
+	 * simulated. State can be interpolated by it to render smoothly.
+	 */
+	F32 GetSimulationAlpha() noexcept;
+
+	U64 GetTime() noexcept;
+	void MarkInput() noexcept;
+	void MarkInput(U64 time) noexcept;
+	PacingStats GetPacingStats() noexcept;
+
+	/*
+	 * Offscreen render targets.
+	 *
+	 * Pixels of target are kept between frames, so layers, which are rarely
+	 * changing, can be redrawn only when needed and composited every frame.
+	 */
+	Surface *CreateTarget(U32 w, U32 h, 
+	                      PixelFormat format = PixelFormat::BGRA8888) noexcept;
+	void DestroyTarget(Surface *target) noexcept;
+
+	/*
+	 * Sparse canvas of up to `BMR_CANVAS_MAX_SIZE` pixels along each side,
+	 * always in `BGRA8888`. Its tiles are allocated, when something is
+	 * drawn over them first time, so memory is proportional to drawn
+	 * content. Tiles, which were never drawn, are `background`.
+	 *
+	 * Commands between `BeginDrawing(canvas)` and `EndDrawing` are given
+	 * in coordinates of canvas. `Clear` frees every tile instead of
+	 * filling them. `DrawGrad`, which covers whole target, `Blur` and
+	 * `Downsample` are ignored.
+	 */
+	struct Canvas;
+
+	Canvas *CreateCanvas(U32 w, U32 h, const Color4 &background) noexcept;
+	void DestroyCanvas(Canvas *canvas) noexcept;
+	void BeginDrawing(Canvas *canvas) noexcept;
+
+	/*
+	 * Memory, which is held by pixels of canvas.
+	 */
+	Size GetCanvasMemory(const Canvas *canvas) noexcept;
+
+	/*
+	 * Images, which are loaded from BMP or QOI files, at most
+	 * `BMR_ASSET_MAX_SIZE` pixels along each side. Pixels are `BGRA8888`
+	 * surface, which can be drawn with `DrawTarget`. Top-down 32-bit BMP,
+	 * which pixel data is aligned to 4 bytes, is used right from the memory
+	 * mapped file and must not be drawn into, others are decoded.
+	 *
+	 * `LoadAssets` loads files in parallel, entries of `assets`, which
+	 * failed to load, are `nullptr`. Returns number of loaded assets.
+	 * Must not be called during `EndDrawing`.
+	 */
+	struct Asset;
+
+	Asset *LoadAsset(CStr path) noexcept;
+	U64 LoadAssets(const CStr *paths, U64 count, Out Asset **assets) noexcept;
+	void DestroyAsset(Asset *asset) noexcept;
+	Surface *GetAssetSurface(Asset *asset) noexcept;
+
 	void SetClearColor(const Color4 &c) noexcept;
 
+	/*
+	 * Changes pixel format of backbuffer. Backbuffer is reallocated, if it
+	 * was already allocated. Formats, which differ from layout of frame,
+	 * are converted only when frame is presented.
+	 */
+	void SetPixelFormat(PixelFormat format) noexcept;
+
+	/*
+	 * Sets colors, which are used by `INDEXED8` backbuffer and targets.
+	 * At most 256 colors are used.
+	 */
+	void SetPalette(const Color4 *colors, U32 count) noexcept;
+
+	/*
+	 * Transform stack. Pushed transform is applied before ones, which are
+	 * already on the stack, so it works in their space. Stack is emptied
+	 * by `BeginDrawing`, at most `BMR_TRANSFORM_STACK_DEPTH` transforms
+	 * are kept.
+	 *
+	 * Lines, rects and targets are transformed, clear, gradients, canvas
+	 * and post-processing are not. Rects, which stay axis aligned, are
+	 * filled as usual, targets, which are only moved, are composited as
+	 * usual at the nearest pixel. Others are rasterized by their edges,
+	 * pixels are sampled at their centers, targets bilinearly.
+	 */
+	void PushTransform(const Transform &t) noexcept;
+	void PopTransform() noexcept;
+
     void Clear() noexcept;
 
-    void DrawLine(U32 x1, U32 y1, U32 x2, U32 y2) noexcept;
-    void DrawLine(Vec2u p1, Vec2u p2) noexcept;
+    /*
+     * Mode is captured by each line, when it's pushed.
+     */
+    void SetLineMode(LineMode mode) noexcept;
+
+    void DrawLine(U32 x1, U32 y1, U32 x2, U32 y2, const Color4 &c) noexcept;
+    void DrawLine(Vec2u p1, Vec2u p2, const Color4 &c) noexcept;
 
 	void DrawRect(const Rect &r, const Color4 &c) noexcept;
 	void DrawRect(U32 x, U32 y, U32 w, U32 h, const Color4 &c) noexcept;
@@ -67,6 +433,44 @@ namespace BMR {
 	void DrawGrad(U32 xOffset, U32 yOffset) noexcept;
 	void DrawGrad(Vec2u offset) noexcept;
 
+	/*
+	 * Fills `area` with gradient. Only first `BMR_GRADIENT_MAX_STOPS` stops
+	 * are used.
+	 */
+	void DrawLinearGradient(const Rect &area, Vec2i start, Vec2i end, 
+	                        const GradientStop *stops, U32 count, 
+	                        GradientSpread spread = GradientSpread::CLAMP) noexcept;
+	void DrawRadialGradient(const Rect &area, Vec2i center, U32 radius, 
+	                        const GradientStop *stops, U32 count, 
+	                        GradientSpread spread = GradientSpread::CLAMP) noexcept;
+
+	void DrawTarget(const Surface *target, U32 x, U32 y, 
+	                U8 opacity = MAX_U8, 
+	                BlendMode mode = BlendMode::NORMAL) noexcept;
+	void DrawTarget(const Surface *target, Vec2u position, 
+	                U8 opacity = MAX_U8, 
+	                BlendMode mode = BlendMode::NORMAL) noexcept;
+
+	/*
+	 * Copies `viewport` of canvas, so its top left corner is at `x`, `y`.
+	 */
+	void DrawCanvas(const Canvas *canvas, const Rect &viewport, U32 x, U32 y) noexcept;
+
+	/*
+	 * Post-processing of what was drawn into `area` before. Pixels outside
+	 * of area are not read, edge pixels are repeated instead. Only
+	 * `BGRA8888` targets are processed.
+	 *
+	 * `radius` of Gaussian blur is its standard deviation, box blur
+	 * averages `2 * radius + 1` pixels along each axis. Bigger radii are
+	 * clamped to `BMR_BLUR_MAX_RADIUS`.
+	 *
+	 * `Downsample` averages each 2x2 block of area, result is placed in
+	 * top left quarter of area, the rest of it is left as it was.
+	 */
+	void Blur(const Rect &area, U32 radius, BlurKind kind = BlurKind::GAUSSIAN) noexcept;
+	void Downsample(const Rect &area) noexcept;
+
 };  // namespace BMR
 
 #endif  // SBMR_BMR_HPP_INCLUDED
@@ -0,0 +1,43 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Backend.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Glue between renderer core and window backends (`Win32/Window.cpp`,
+ * `X11/Window.cpp`).
+ * Core itself knows nothing about windows, so it also runs headless.
+ * */
+
+#ifndef SBMR_BACKEND_HPP_INCLUDED
+#define SBMR_BACKEND_HPP_INCLUDED
+
+#include "Surface.hpp"
+
+
+namespace BMR {
+
+    /*
+     * Shows finished frame, which is in layout of `GetFrameLayout`.
+     */
+    typedef void (*PresentProc)(const Surface *frame) noexcept;
+
+    /*
+     * Sets procedure, which `EndDrawing` calls after backbuffer was
+     * rasterized.
+     */
+    void Backend_SetPresent(PresentProc present) noexcept;
+
+    /*
+     * Gives memory, which backend presents from. `Resize` places frame
+     * into it, when frame fits, so backend doesn't need to copy it.
+     * Memory is used until it's unset with `nullptr`.
+     */
+    void Backend_SetFramebuffer(void *memory, Size size) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_BACKEND_HPP_INCLUDED
@@ -0,0 +1,209 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Canvas.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Canvas.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "Memory.hpp"
+#include "Debug.hpp"
+
+
+namespace BMR {
+
+    InternalFunc U8 **
+    _GetTileSlot(const Canvas *canvas, S64 tx, S64 ty) noexcept
+    {
+        CanvasChunk *chunk = canvas->Chunks[
+            (ty / BMR_CANVAS_CHUNK_TILES) * BMR_CANVAS_MAX_CHUNKS + tx / BMR_CANVAS_CHUNK_TILES];
+
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+
+        return &chunk->Tiles[
+            (ty % BMR_CANVAS_CHUNK_TILES) * BMR_CANVAS_CHUNK_TILES + tx % BMR_CANVAS_CHUNK_TILES];
+    }
+
+    InternalFunc void
+    _MakeTileView(const Canvas *canvas, U8 *pixels, S64 tx, S64 ty,
+                  Out Surface *tile) noexcept
+    {
+        S64 x = tx * BMR_CANVAS_TILE_SIZE;
+        S64 y = ty * BMR_CANVAS_TILE_SIZE;
+
+        *tile = Surface{};
+        tile->Buffer = pixels;
+        tile->Width = (U64)(canvas->Width - x < BMR_CANVAS_TILE_SIZE ? canvas->Width - x : BMR_CANVAS_TILE_SIZE);
+        tile->Height = (U64)(canvas->Height - y < BMR_CANVAS_TILE_SIZE ? canvas->Height - y : BMR_CANVAS_TILE_SIZE);
+        tile->Pitch = BMR_CANVAS_TILE_SIZE * 4;
+        tile->Format = PixelFormat::BGRA8888;
+        tile->X = x;
+        tile->Y = y;
+    }
+
+    Canvas *
+    Canvas_Create(U32 w, U32 h, const Color4 &background) noexcept
+    {
+        if (w == 0 || h == 0 || w > BMR_CANVAS_MAX_SIZE || h > BMR_CANVAS_MAX_SIZE) {
+            Debug_Print("Canvas size is out of range!\n");
+            return nullptr;
+        }
+
+        auto *canvas = (Canvas *)Memory_Allocate(sizeof(Canvas));
+        if (canvas == nullptr) {
+            Debug_Print("Failed to allocate memory for canvas!\n");
+            return nullptr;
+        }
+
+        *canvas = Canvas{};
+        canvas->Width = w;
+        canvas->Height = h;
+        canvas->Background = background;
+        return canvas;
+    }
+
+    void
+    Canvas_Clear(Canvas *canvas, const Color4 &background) noexcept
+    {
+        for (CanvasChunk *&chunk : canvas->Chunks) {
+            if (chunk == nullptr) {
+                continue;
+            }
+
+            for (U8 *tile : chunk->Tiles) {
+                if (tile != nullptr) {
+                    Memory_Free(tile, BMR_CANVAS_TILE_BYTES);
+                }
+            }
+
+            Memory_Free(chunk, sizeof(CanvasChunk));
+            chunk = nullptr;
+        }
+
+        canvas->TileCount = 0;
+        canvas->ChunkCount = 0;
+        canvas->Background = background;
+    }
+
+    void
+    Canvas_Destroy(Canvas *canvas) noexcept
+    {
+        if (canvas == nullptr) {
+            return;
+        }
+
+        Canvas_Clear(canvas, canvas->Background);
+        Memory_Free(canvas, sizeof(Canvas));
+    }
+
+    bool
+    Canvas_GetTile(Canvas *canvas, S64 x, S64 y, bool commit,
+                   Out Surface *tile) noexcept
+    {
+        if (x < 0 || y < 0 || x >= canvas->Width || y >= canvas->Height) {
+            return false;
+        }
+
+        S64 tx = x / BMR_CANVAS_TILE_SIZE;
+        S64 ty = y / BMR_CANVAS_TILE_SIZE;
+
+        U8 **slot = _GetTileSlot(canvas, tx, ty);
+        if (slot != nullptr && *slot != nullptr) {
+            _MakeTileView(canvas, *slot, tx, ty, tile);
+            return true;
+        }
+
+        if (!commit) {
+            return false;
+        }
+
+        if (slot == nullptr) {
+            CanvasChunk *&chunk = canvas->Chunks[
+                (ty / BMR_CANVAS_CHUNK_TILES) * BMR_CANVAS_MAX_CHUNKS + tx / BMR_CANVAS_CHUNK_TILES];
+
+            // NOTE(ilya.a): Fresh pages are zeroed, so every tile of new
+            // chunk is missing.
+            chunk = (CanvasChunk *)Memory_Allocate(sizeof(CanvasChunk));
+            if (chunk == nullptr) {
+                Debug_Print("Failed to allocate memory for canvas chunk!\n");
+                return false;
+            }
+
+            canvas->ChunkCount++;
+            slot = _GetTileSlot(canvas, tx, ty);
+        }
+
+        *slot = (U8 *)Memory_Allocate(BMR_CANVAS_TILE_BYTES);
+        if (*slot == nullptr) {
+            Debug_Print("Failed to allocate memory for canvas tile!\n");
+            return false;
+        }
+
+        canvas->TileCount++;
+        _MakeTileView(canvas, *slot, tx, ty, tile);
+        Raster_Fill(tile, Raster_GetSurfaceClip(tile), Raster_GetSurfaceClip(tile), canvas->Background);
+        return true;
+    }
+
+    void
+    Canvas_Present(Surface *dst, const Clip &clip,
+                   const Canvas *canvas, const Clip &viewport,
+                   S64 x, S64 y) noexcept
+    {
+        if (canvas == nullptr) {
+            return;
+        }
+
+        // NOTE(ilya.a): Only part of viewport, which is visible in `dst`,
+        // is walked, so viewport may be as big as canvas.
+        S64 dx = x - viewport.X0;
+        S64 dy = y - viewport.Y0;
+        Clip area = viewport
+            .Intersect(Clip{0, 0, canvas->Width, canvas->Height})
+            .Intersect(Clip{clip.X0 - dx, clip.Y0 - dy, clip.X1 - dx, clip.Y1 - dy});
+        Clip surface = Raster_GetSurfaceClip(dst);
+        area = area.Intersect(Clip{surface.X0 - dx, surface.Y0 - dy, surface.X1 - dx, surface.Y1 - dy});
+
+        if (area.IsEmpty()) {
+            return;
+        }
+
+        S64 tx0 = area.X0 / BMR_CANVAS_TILE_SIZE, tx1 = (area.X1 - 1) / BMR_CANVAS_TILE_SIZE;
+        S64 ty0 = area.Y0 / BMR_CANVAS_TILE_SIZE, ty1 = (area.Y1 - 1) / BMR_CANVAS_TILE_SIZE;
+
+        for (S64 ty = ty0; ty <= ty1; ++ty) {
+            for (S64 tx = tx0; tx <= tx1; ++tx) {
+                Clip tileArea = area.Intersect(Clip{
+                    tx * BMR_CANVAS_TILE_SIZE, ty * BMR_CANVAS_TILE_SIZE,
+                    (tx + 1) * BMR_CANVAS_TILE_SIZE, (ty + 1) * BMR_CANVAS_TILE_SIZE,
+                });
+                Clip target = Clip{
+                    tileArea.X0 + dx, tileArea.Y0 + dy, tileArea.X1 + dx, tileArea.Y1 + dy,
+                };
+
+                U8 **slot = _GetTileSlot(canvas, tx, ty);
+                if (slot == nullptr || *slot == nullptr) {
+                    Raster_Fill(dst, target, target, canvas->Background);
+                    continue;
+                }
+
+                Surface tile;
+                _MakeTileView(canvas, *slot, tx, ty, &tile);
+                Raster_Composite(
+                    dst, target, &tile, tile.X + dx, tile.Y + dy, MAX_U8, BlendMode::NORMAL);
+            }
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,77 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Canvas.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Sparse canvas. Pixels are kept in tiles, which are allocated, when
+ * something is drawn over them first time. Directory of tiles is split in
+ * chunks, which are allocated the same way, so untouched parts of canvas
+ * cost nothing.
+ * */
+
+#ifndef SBMR_CANVAS_HPP_INCLUDED
+#define SBMR_CANVAS_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "BMR.hpp"
+
+
+#define BMR_CANVAS_TILE_SIZE   64
+#define BMR_CANVAS_CHUNK_TILES 64  // NOTE(ilya.a): Tiles along side of chunk.
+#define BMR_CANVAS_CHUNK_SIZE  (BMR_CANVAS_TILE_SIZE * BMR_CANVAS_CHUNK_TILES)
+#define BMR_CANVAS_MAX_CHUNKS  ((BMR_CANVAS_MAX_SIZE + BMR_CANVAS_CHUNK_SIZE - 1) / BMR_CANVAS_CHUNK_SIZE)
+
+#define BMR_CANVAS_TILE_BYTES  (BMR_CANVAS_TILE_SIZE * BMR_CANVAS_TILE_SIZE * 4)
+
+
+namespace BMR {
+
+    struct CanvasChunk {
+        U8 *Tiles[BMR_CANVAS_CHUNK_TILES * BMR_CANVAS_CHUNK_TILES];
+    };
+
+    struct Canvas {
+        U32    Width;
+        U32    Height;
+        Color4 Background;  // NOTE(ilya.a): Color of tiles, which were never drawn.
+
+        U64 TileCount;
+        U64 ChunkCount;
+        CanvasChunk *Chunks[BMR_CANVAS_MAX_CHUNKS * BMR_CANVAS_MAX_CHUNKS];
+    };
+
+    Canvas *Canvas_Create(U32 w, U32 h, const Color4 &background) noexcept;
+    void Canvas_Destroy(Canvas *canvas) noexcept;
+
+    /*
+     * Frees every tile, so whole canvas becomes `background`.
+     */
+    void Canvas_Clear(Canvas *canvas, const Color4 &background) noexcept;
+
+    /*
+     * Makes `tile` a view of tile, which contains pixel `x`, `y`. Tile is
+     * allocated and filled with background, if `commit` is set, otherwise
+     * `false` is returned for tile, which was never drawn. Tile is a
+     * `BGRA8888` surface in coordinates of canvas.
+     */
+    bool Canvas_GetTile(Canvas *canvas, S64 x, S64 y, bool commit,
+                        Out Surface *tile) noexcept;
+
+    /*
+     * Copies `viewport` of canvas to `dst`, so its top left corner is at
+     * `x`, `y`.
+     */
+    void Canvas_Present(Surface *dst, const Clip &clip,
+                        const Canvas *canvas, const Clip &viewport,
+                        S64 x, S64 y) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_CANVAS_HPP_INCLUDED
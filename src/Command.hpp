@@ -0,0 +1,232 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Command.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Layout of render commands in the queue. Private to renderer and tools,
+ * which are reading queue directly (`Reference.cpp`).
+ * */
+
+#ifndef SBMR_COMMAND_HPP_INCLUDED
+#define SBMR_COMMAND_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Lin.hpp"
+#include "Geom.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "Memory.hpp"
+#include "BMR.hpp"
+
+
+// NOTE(ilya.a): Alignment of every record in command queue.
+#define BMR_COMMAND_ALIGNMENT 8
+
+
+namespace BMR {
+
+    struct _DrawLine_Payload {
+        Vec2u p1;
+        Vec2u p2;
+        Color4 Color;
+        LineMode Mode;
+    };
+
+    struct _DrawRect_Payload {
+        ::Rect Rect;
+        Color4 Color;
+    };
+
+    /*
+     * NOTE(ilya.a): Padding in payloads is spelled out, so it is zeroed
+     * with the rest of the payload. Tile cache hashes raw command bytes,
+     * and garbage in padding makes equal commands hash differently.
+     * */
+
+    struct _DrawQuad_Payload {
+        ::Rect Rect;
+        Color4 Color;
+        U32 _Padding;
+        ::Transform Transform;
+    };
+
+    struct _DrawGradient_Payload {
+        Rect Area;
+        BMR::Gradient Gradient;
+    };
+
+    struct _DrawTarget_Payload {
+        const Surface *Target;
+        Vec2u Position;
+        U8 Opacity;
+        U8 _Padding[3];
+        BlendMode Mode;
+    };
+
+    // NOTE(ilya.a): Source pointer is read from the queue in place, which
+    // is only valid, because records are padded to its alignment.
+    static_assert(alignof(RenderCommand<_DrawTarget_Payload>) <= BMR_COMMAND_ALIGNMENT);
+
+    struct _DrawSprite_Payload {
+        const Surface *Target;
+        Vec2u Position;
+        U8 Opacity;
+        U8 _Padding[3];
+        BlendMode Mode;
+        ::Transform Transform;
+    };
+
+    /*
+     * Rect, which sprite is covering before it's transformed.
+     */
+    inline Rect
+    Command_GetSpriteRect(const _DrawSprite_Payload &p) noexcept
+    {
+        return Rect{p.Position.X, p.Position.Y, (U32)p.Target->Width, (U32)p.Target->Height};
+    }
+
+    struct _Blur_Payload {
+        Rect Area;
+        U32 Radius;
+        BlurKind Kind;
+    };
+
+    struct _DrawCanvas_Payload {
+        const BMR::Canvas *Source;
+        Rect Viewport;
+        Vec2u Position;
+    };
+
+    static_assert(alignof(RenderCommand<_DrawCanvas_Payload>) <= BMR_COMMAND_ALIGNMENT);
+
+    /*
+     * Size of record, which command of `size` bytes takes in queue. Every
+     * record is padded, so the next one is aligned for pointers and 64-bit
+     * fields of payloads, wherever it is.
+     */
+    constexpr Size
+    Command_GetRecordSize(Size size) noexcept
+    {
+        return AlignUp(size, BMR_COMMAND_ALIGNMENT);
+    }
+
+    constexpr Size
+    _Command_GetUnpaddedSize(RenderCommandType type) noexcept
+    {
+        switch (type) {
+            case (RenderCommandType::NOP):             return sizeof(RenderCommandType);
+            case (RenderCommandType::CLEAR):           return sizeof(RenderCommand<Color4>);
+            case (RenderCommandType::LINE):            return sizeof(RenderCommand<_DrawLine_Payload>);
+            case (RenderCommandType::RECT):            return sizeof(RenderCommand<_DrawRect_Payload>);
+            case (RenderCommandType::QUAD):            return sizeof(RenderCommand<_DrawQuad_Payload>);
+            case (RenderCommandType::GRADIENT):        return sizeof(RenderCommand<Vec2u>);
+            case (RenderCommandType::LINEAR_GRADIENT):
+            case (RenderCommandType::RADIAL_GRADIENT): return sizeof(RenderCommand<_DrawGradient_Payload>);
+            case (RenderCommandType::COMPOSITE):       return sizeof(RenderCommand<_DrawTarget_Payload>);
+            case (RenderCommandType::SPRITE):          return sizeof(RenderCommand<_DrawSprite_Payload>);
+            case (RenderCommandType::CANVAS):          return sizeof(RenderCommand<_DrawCanvas_Payload>);
+            case (RenderCommandType::BLUR):            return sizeof(RenderCommand<_Blur_Payload>);
+            case (RenderCommandType::DOWNSAMPLE):      return sizeof(RenderCommand<Rect>);
+            default:                                   return 0;
+        }
+    }
+
+    /*
+     * Returns size of record of command of given type, including its type
+     * and padding, or zero if type is unknown.
+     */
+    constexpr Size
+    Command_GetSize(RenderCommandType type) noexcept
+    {
+        return Command_GetRecordSize(_Command_GetUnpaddedSize(type));
+    }
+
+    /*
+     * Pixels of `target`, which command may touch. Conservative for lines,
+     * quads and sprites, exact for everything else.
+     */
+    inline Clip
+    Command_GetBounds(const U8 *command, const Clip &target) noexcept
+    {
+        switch (*((const RenderCommandType *)command)) {
+            case (RenderCommandType::CLEAR):
+            case (RenderCommandType::GRADIENT): {
+                return target;
+            } break;
+            case (RenderCommandType::RECT): {
+                const Rect &r = ((const RenderCommand<_DrawRect_Payload> *)command)->Payload.Rect;
+                return target.Intersect(Raster_GetRectClip(r));
+            } break;
+            case (RenderCommandType::QUAD): {
+                const _DrawQuad_Payload &p = ((const RenderCommand<_DrawQuad_Payload> *)command)->Payload;
+                return target.Intersect(Raster_GetAffineMap(p.Transform, p.Rect).Bounds);
+            } break;
+            case (RenderCommandType::LINEAR_GRADIENT):
+            case (RenderCommandType::RADIAL_GRADIENT): {
+                const Rect &r = ((const RenderCommand<_DrawGradient_Payload> *)command)->Payload.Area;
+                return target.Intersect(Raster_GetRectClip(r));
+            } break;
+            case (RenderCommandType::BLUR): {
+                const Rect &r = ((const RenderCommand<_Blur_Payload> *)command)->Payload.Area;
+                return target.Intersect(Raster_GetRectClip(r));
+            } break;
+            case (RenderCommandType::DOWNSAMPLE): {
+                const Rect &r = ((const RenderCommand<Rect> *)command)->Payload;
+                return target.Intersect(Raster_GetRectClip(r));
+            } break;
+            case (RenderCommandType::LINE): {
+                const _DrawLine_Payload &p = ((const RenderCommand<_DrawLine_Payload> *)command)->Payload;
+                S64 x0 = p.p1.X < p.p2.X ? p.p1.X : p.p2.X;
+                S64 x1 = p.p1.X < p.p2.X ? p.p2.X : p.p1.X;
+                S64 y0 = p.p1.Y < p.p2.Y ? p.p1.Y : p.p2.Y;
+                S64 y1 = p.p1.Y < p.p2.Y ? p.p2.Y : p.p1.Y;
+
+                // NOTE(ilya.a): Antialiased line is also covering pixel
+                // next to it along minor axis.
+                return target.Intersect(Clip{x0 - 1, y0 - 1, x1 + 2, y1 + 2});
+            } break;
+            case (RenderCommandType::COMPOSITE): {
+                const _DrawTarget_Payload &p = ((const RenderCommand<_DrawTarget_Payload> *)command)->Payload;
+                if (p.Target == nullptr || p.Target->Buffer == nullptr) {
+                    return Clip{};
+                }
+
+                return target.Intersect(Clip{
+                    p.Position.X, p.Position.Y,
+                    (S64)p.Position.X + (S64)p.Target->Width,
+                    (S64)p.Position.Y + (S64)p.Target->Height});
+            } break;
+            case (RenderCommandType::SPRITE): {
+                const _DrawSprite_Payload &p = ((const RenderCommand<_DrawSprite_Payload> *)command)->Payload;
+                if (p.Target == nullptr || p.Target->Buffer == nullptr) {
+                    return Clip{};
+                }
+
+                return target.Intersect(Raster_GetAffineMap(p.Transform, Command_GetSpriteRect(p)).Bounds);
+            } break;
+            case (RenderCommandType::CANVAS): {
+                const _DrawCanvas_Payload &p = ((const RenderCommand<_DrawCanvas_Payload> *)command)->Payload;
+                if (p.Source == nullptr) {
+                    return Clip{};
+                }
+
+                return target.Intersect(Clip{
+                    p.Position.X, p.Position.Y,
+                    (S64)p.Position.X + (S64)p.Viewport.Width,
+                    (S64)p.Position.Y + (S64)p.Viewport.Height});
+            } break;
+            case (RenderCommandType::NOP):
+            default: {
+                return Clip{};
+            } break;
+        }
+    }
+
+};  // namespace BMR
+
+#endif  // SBMR_COMMAND_HPP_INCLUDED
@@ -0,0 +1,37 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Debug.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#ifndef SBMR_DEBUG_HPP_INCLUDED
+#define SBMR_DEBUG_HPP_INCLUDED
+
+#if defined(_WIN32)
+    #include <Windows.h>
+#else
+    #include <stdio.h>
+#endif
+
+#include "Types.hpp"
+
+
+/*
+ * Prints message to debugger output on Windows, and to `stderr` elsewhere.
+ */
+inline void
+Debug_Print(CStr message) noexcept
+{
+#if defined(_WIN32)
+    OutputDebugStringA(message);
+#else
+    fputs(message, stderr);
+#endif
+}
+
+
+#endif  // SBMR_DEBUG_HPP_INCLUDED
@@ -0,0 +1,479 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Filter.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Post-processing kernels. Blur is separable: rows are blurred first,
+ * then columns, each with running sum, so cost per pixel doesn't depend
+ * on radius. Gaussian is approximated by three box passes. Downsample
+ * and resolve of supersampled backbuffer average blocks of pixels with
+ * integer sums, one pass over memory.
+ * */
+
+#include <string.h>
+#include <math.h>
+
+#include "Raster.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Memory.hpp"
+#include "Job.hpp"
+#include "Debug.hpp"
+#include "Simd.hpp"
+
+
+// NOTE(ilya.a): Columns are blurred in blocks of this many pixels, which
+// are copied out, so each row of block is a single cache line.
+#define BMR_FILTER_BLOCK_WIDTH (BMR_CACHE_LINE_SIZE / 4)
+
+#define BMR_FILTER_ROW_GRAIN    16
+#define BMR_FILTER_MAX_PASSES   3
+#define BMR_FILTER_SCRATCH_SIZE ((Size)1 << 30)
+
+
+GlobalVar BMR::VirtualBuffer FilterScratch;
+
+
+namespace BMR {
+
+    /*
+     * Scratch memory, which is kept between commands, so pages are only
+     * touched once.
+     */
+    InternalFunc U8 *
+    _GetScratch(Size size) noexcept
+    {
+        if (FilterScratch.Base == nullptr
+            && !VirtualBuffer_Reserve(&FilterScratch, BMR_FILTER_SCRATCH_SIZE, false)) {
+            return nullptr;
+        }
+
+        if (size > FilterScratch.Reserved || !VirtualBuffer_Resize(&FilterScratch, size)) {
+            Debug_Print("Not enough scratch memory for post-processing!\n");
+            return nullptr;
+        }
+
+        return FilterScratch.Base;
+    }
+
+    void
+    Raster_ReleaseScratch() noexcept
+    {
+        VirtualBuffer_Release(&FilterScratch);
+    }
+
+#if BMR_SIMD_SSE2
+    /*
+     * Pixel, which is unpacked into four 32-bit lanes.
+     */
+    InternalFunc inline __m128i
+    _LoadWide(const Color4 *pixel, __m128i zero) noexcept
+    {
+        S32 v;
+        memcpy(&v, pixel, sizeof(v));
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+    }
+#endif
+
+    /*
+     * Box blur of `count` pixels, which are `step` pixels apart. Edge
+     * pixels are repeated. `in` and `out` must not overlap.
+     */
+    InternalFunc void
+    _BoxLine(const Color4 *in, S64 inStep, Color4 *out, S64 outStep,
+             S64 count, S64 radius) noexcept
+    {
+        const F32 scale = 1.0f / (F32)(2 * radius + 1);
+        const S64 last = count - 1;
+
+        U32 init[4] = {
+            (U32)(radius + 1) * in[0].B, (U32)(radius + 1) * in[0].G,
+            (U32)(radius + 1) * in[0].R, (U32)(radius + 1) * in[0].A,
+        };
+        for (S64 i = 1; i <= radius; ++i) {
+            const Color4 &c = in[(i < last ? i : last) * inStep];
+            init[0] += c.B; init[1] += c.G; init[2] += c.R; init[3] += c.A;
+        }
+
+#if BMR_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 s = _mm_set1_ps(scale);
+
+        __m128i sum = _mm_setr_epi32((int)init[0], (int)init[1], (int)init[2], (int)init[3]);
+
+        for (S64 x = 0; x < count; ++x) {
+            __m128i v = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), s));
+            v = _mm_packs_epi32(v, v);
+            S32 packed = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+            memcpy((void *)(out + x * outStep), &packed, sizeof(packed));
+
+            S64 add = x + radius + 1 < last ? x + radius + 1 : last;
+            S64 sub = x - radius > 0 ? x - radius : 0;
+            sum = _mm_add_epi32(sum, _mm_sub_epi32(
+                _LoadWide(in + add * inStep, zero), _LoadWide(in + sub * inStep, zero)));
+        }
+#else
+        U32 sum[4] = { init[0], init[1], init[2], init[3] };
+
+        for (S64 x = 0; x < count; ++x) {
+            Color4 &o = out[x * outStep];
+            o.B = (U8)nearbyintf((F32)sum[0] * scale);
+            o.G = (U8)nearbyintf((F32)sum[1] * scale);
+            o.R = (U8)nearbyintf((F32)sum[2] * scale);
+            o.A = (U8)nearbyintf((F32)sum[3] * scale);
+
+            S64 add = x + radius + 1 < last ? x + radius + 1 : last;
+            S64 sub = x - radius > 0 ? x - radius : 0;
+            const Color4 &a = in[add * inStep];
+            const Color4 &b = in[sub * inStep];
+            sum[0] += a.B - b.B; sum[1] += a.G - b.G;
+            sum[2] += a.R - b.R; sum[3] += a.A - b.A;
+        }
+#endif
+    }
+
+    /*
+     * Runs box passes one after another, ping-ponging between `a` and `b`.
+     * Input is expected in `a`, the last pass writes to `out`.
+     */
+    InternalFunc void
+    _BoxPasses(Color4 *a, Color4 *b, S64 step, Color4 *out, S64 outStep,
+               S64 count, const U32 *radii, U32 passCount) noexcept
+    {
+        Color4 *src = a;
+        Color4 *tmp = b;
+
+        for (U32 i = 0; i < passCount; ++i) {
+            bool isLast = i + 1 == passCount;
+            Color4 *dst = isLast ? out : tmp;
+
+            _BoxLine(src, step, dst, isLast ? outStep : step, count, radii[i]);
+
+            tmp = src;
+            src = dst;
+        }
+    }
+
+    /*
+     * Box sizes, three passes of which have the same variance as Gaussian
+     * with given standard deviation.
+     */
+    InternalFunc void
+    _GetGaussianRadii(F64 sigma, Out U32 *radii) noexcept
+    {
+        const F64 n = BMR_FILTER_MAX_PASSES;
+
+        S64 lower = (S64)floor(sqrt(12.0 * sigma * sigma / n + 1.0));
+        if (lower % 2 == 0) {
+            lower--;
+        }
+        S64 upper = lower + 2;
+
+        F64 ideal = (12.0 * sigma * sigma - n * lower * lower - 4.0 * n * lower - 3.0 * n)
+                  / (-4.0 * lower - 4.0);
+        S64 m = (S64)floor(ideal + 0.5);
+
+        for (S64 i = 0; i < BMR_FILTER_MAX_PASSES; ++i) {
+            S64 size = i < m ? lower : upper;
+            radii[i] = (U32)((size - 1) / 2);
+        }
+    }
+
+    struct _BlurJob {
+        Surface *Dst;
+        Clip Area;
+        U32 Radii[BMR_FILTER_MAX_PASSES];
+        U32 PassCount;
+
+        Color4 *Scratch;
+        Size SlicePixels;  // NOTE(ilya.a): Per worker, split in two halves.
+    };
+
+    InternalFunc void
+    _BlurRows(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        auto *job = (const _BlurJob *)data;
+        S64 width = job->Area.X1 - job->Area.X0;
+
+        Color4 *a = job->Scratch + worker * job->SlicePixels;
+        Color4 *b = a + job->SlicePixels / 2;
+
+        for (U64 row = begin; row < end; ++row) {
+            Color4 *pixels = (Color4 *)GetPixelAddress(job->Dst, job->Area.X0, job->Area.Y0 + (S64)row);
+
+            memcpy(a, pixels, (Size)width * sizeof(Color4));
+            _BoxPasses(a, b, 1, pixels, 1, width, job->Radii, job->PassCount);
+        }
+    }
+
+    InternalFunc void
+    _BlurColumns(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        auto *job = (const _BlurJob *)data;
+        S64 height = job->Area.Y1 - job->Area.Y0;
+        S64 pitch = (S64)job->Dst->Pitch / (S64)sizeof(Color4);
+
+        Color4 *a = job->Scratch + worker * job->SlicePixels;
+        Color4 *b = a + job->SlicePixels / 2;
+
+        for (U64 block = begin; block < end; ++block) {
+            S64 x0 = job->Area.X0 + (S64)block * BMR_FILTER_BLOCK_WIDTH;
+            S64 width = job->Area.X1 - x0 < BMR_FILTER_BLOCK_WIDTH ? job->Area.X1 - x0 : BMR_FILTER_BLOCK_WIDTH;
+            Color4 *pixels = (Color4 *)GetPixelAddress(job->Dst, x0, job->Area.Y0);
+
+            for (S64 y = 0; y < height; ++y) {
+                memcpy(a + y * BMR_FILTER_BLOCK_WIDTH, pixels + y * pitch, (Size)width * sizeof(Color4));
+            }
+
+            for (S64 x = 0; x < width; ++x) {
+                _BoxPasses(
+                    a + x, b + x, BMR_FILTER_BLOCK_WIDTH, pixels + x, pitch,
+                    height, job->Radii, job->PassCount);
+            }
+        }
+    }
+
+    void
+    Raster_Blur(Surface *dst, const Clip &clip, const Clip &area,
+                U32 radius, BlurKind kind) noexcept
+    {
+        Clip r = area.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty() || radius == 0 || dst->Format != PixelFormat::BGRA8888) {
+            return;
+        }
+
+        _BlurJob job = {};
+        job.Dst = dst;
+        job.Area = r;
+
+        if (kind == BlurKind::GAUSSIAN) {
+            _GetGaussianRadii(radius, job.Radii);
+            job.PassCount = BMR_FILTER_MAX_PASSES;
+        } else {
+            job.Radii[0] = radius;
+            job.PassCount = 1;
+        }
+
+        S64 width = r.X1 - r.X0;
+        S64 height = r.Y1 - r.Y0;
+        S64 rowPixels = width;
+        S64 blockPixels = height * BMR_FILTER_BLOCK_WIDTH;
+
+        job.SlicePixels = 2 * (Size)(rowPixels > blockPixels ? rowPixels : blockPixels);
+        job.Scratch = (Color4 *)_GetScratch(
+            job.SlicePixels * sizeof(Color4) * (Job_GetWorkerCount() + 1));
+        if (job.Scratch == nullptr) {
+            return;
+        }
+
+        U64 blocks = (U64)(width + BMR_FILTER_BLOCK_WIDTH - 1) / BMR_FILTER_BLOCK_WIDTH;
+        Job_ParallelFor((U64)height, BMR_FILTER_ROW_GRAIN, _BlurRows, &job);
+        Job_ParallelFor(blocks, 1, _BlurColumns, &job);
+    }
+
+    /*
+     * Averages each 2x2 block of rows `a` and `b` into `count` pixels.
+     */
+    InternalFunc void
+    _Average2x2(const Color4 *a, const Color4 *b, S64 count, Out Color4 *out) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+
+        // NOTE(ilya.a): Four source pixels of both rows give two.
+        for (; x + 2 <= count; x += 2) {
+            __m128i va = _mm_loadu_si128((const __m128i *)(a + 2 * x));
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + 2 * x));
+
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+            __m128i v = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+            _mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(v, v));
+        }
+#endif
+        for (; x < count; ++x) {
+            const Color4 &p0 = a[2 * x], &p1 = a[2 * x + 1];
+            const Color4 &p2 = b[2 * x], &p3 = b[2 * x + 1];
+
+            out[x].B = (U8)((p0.B + p1.B + p2.B + p3.B + 2) >> 2);
+            out[x].G = (U8)((p0.G + p1.G + p2.G + p3.G + 2) >> 2);
+            out[x].R = (U8)((p0.R + p1.R + p2.R + p3.R + 2) >> 2);
+            out[x].A = (U8)((p0.A + p1.A + p2.A + p3.A + 2) >> 2);
+        }
+    }
+
+    /*
+     * Averages each 4x4 block of `rows` into `count` pixels.
+     */
+    InternalFunc void
+    _Average4x4(const Color4 *const rows[4], S64 count, Out Color4 *out) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i eight = _mm_set1_epi16(8);
+
+        // NOTE(ilya.a): Each row of block is a single load. Sum of 16
+        // samples is at most 4080, so 16-bit lanes are enough.
+        for (; x + 2 <= count; x += 2) {
+            __m128i sum0 = zero, sum1 = zero;
+
+            for (U32 i = 0; i < 4; ++i) {
+                __m128i v0 = _mm_loadu_si128((const __m128i *)(rows[i] + 4 * x));
+                __m128i v1 = _mm_loadu_si128((const __m128i *)(rows[i] + 4 * x + 4));
+                sum0 = _mm_add_epi16(sum0, _mm_add_epi16(_mm_unpacklo_epi8(v0, zero), _mm_unpackhi_epi8(v0, zero)));
+                sum1 = _mm_add_epi16(sum1, _mm_add_epi16(_mm_unpacklo_epi8(v1, zero), _mm_unpackhi_epi8(v1, zero)));
+            }
+
+            sum0 = _mm_add_epi16(sum0, _mm_srli_si128(sum0, 8));
+            sum1 = _mm_add_epi16(sum1, _mm_srli_si128(sum1, 8));
+
+            __m128i v = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum0, sum1), eight), 4);
+            _mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(v, v));
+        }
+#endif
+        for (; x < count; ++x) {
+            U32 b = 8, g = 8, r = 8, a = 8;
+
+            for (U32 i = 0; i < 4; ++i) {
+                for (U32 j = 0; j < 4; ++j) {
+                    const Color4 &p = rows[i][4 * x + j];
+                    b += p.B;
+                    g += p.G;
+                    r += p.R;
+                    a += p.A;
+                }
+            }
+
+            out[x] = Color4((U8)(r >> 4), (U8)(g >> 4), (U8)(b >> 4), (U8)(a >> 4));
+        }
+    }
+
+    struct _DownsampleJob {
+        Surface *Dst;
+        Clip Area;
+        Color4 *Scratch;
+        S64 Width;  // NOTE(ilya.a): Of result.
+    };
+
+    InternalFunc void
+    _DownsampleRows(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        (void)worker;
+        auto *job = (const _DownsampleJob *)data;
+
+        for (U64 row = begin; row < end; ++row) {
+            S64 y = job->Area.Y0 + 2 * (S64)row;
+            const Color4 *a = (const Color4 *)GetPixelAddress(job->Dst, job->Area.X0, y);
+            const Color4 *b = (const Color4 *)GetPixelAddress(job->Dst, job->Area.X0, y + 1);
+            _Average2x2(a, b, job->Width, job->Scratch + row * job->Width);
+        }
+    }
+
+    InternalFunc void
+    _DownsampleStore(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        (void)worker;
+        auto *job = (const _DownsampleJob *)data;
+
+        for (U64 row = begin; row < end; ++row) {
+            memcpy(
+                GetPixelAddress(job->Dst, job->Area.X0, job->Area.Y0 + (S64)row),
+                job->Scratch + row * job->Width, (Size)job->Width * sizeof(Color4));
+        }
+    }
+
+    void
+    Raster_Downsample(Surface *dst, const Clip &clip, const Clip &area) noexcept
+    {
+        Clip r = area.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (dst->Format != PixelFormat::BGRA8888) {
+            return;
+        }
+
+        _DownsampleJob job = {};
+        job.Dst = dst;
+        job.Area = r;
+        job.Width = (r.X1 - r.X0) / 2;
+
+        S64 height = (r.Y1 - r.Y0) / 2;
+        if (job.Width <= 0 || height <= 0) {
+            return;
+        }
+
+        // NOTE(ilya.a): Result is overlapping its source, so it's stored
+        // only after every row is done.
+        job.Scratch = (Color4 *)_GetScratch((Size)(job.Width * height) * sizeof(Color4));
+        if (job.Scratch == nullptr) {
+            return;
+        }
+
+        Job_ParallelFor((U64)height, BMR_FILTER_ROW_GRAIN, _DownsampleRows, &job);
+        Job_ParallelFor((U64)height, BMR_FILTER_ROW_GRAIN, _DownsampleStore, &job);
+    }
+
+    struct _ResolveJob {
+        Surface *Dst;
+        const Surface *Samples;
+        Clip Area;
+        U32 Scale;
+    };
+
+    InternalFunc void
+    _ResolveRows(void *data, U64 begin, U64 end, U32 worker) noexcept
+    {
+        (void)worker;
+        auto *job = (const _ResolveJob *)data;
+        const Clip &r = job->Area;
+        const S64 s = job->Scale;
+
+        for (U64 row = begin; row < end; ++row) {
+            S64 y = r.Y0 + (S64)row;
+            Color4 *out = (Color4 *)GetPixelAddress(job->Dst, r.X0, y);
+
+            const Color4 *rows[4];
+            for (S64 i = 0; i < s; ++i) {
+                rows[i] = (const Color4 *)GetPixelAddress(job->Samples, r.X0 * s, y * s + i);
+            }
+
+            if (s == 2) {
+                _Average2x2(rows[0], rows[1], r.X1 - r.X0, out);
+            } else {
+                _Average4x4(rows, r.X1 - r.X0, out);
+            }
+        }
+    }
+
+    void
+    Raster_Resolve(Surface *dst, const Clip &clip,
+                   const Surface *samples, U32 scale) noexcept
+    {
+        if (dst->Format != PixelFormat::BGRA8888 || samples->Format != PixelFormat::BGRA8888
+            || (scale != 2 && scale != 4)) {
+            return;
+        }
+
+        Clip r = clip.Intersect(Raster_GetSurfaceClip(dst));
+        Clip s = Raster_GetSurfaceClip(samples);
+        r = r.Intersect(Clip{s.X0 / scale, s.Y0 / scale, s.X1 / scale, s.Y1 / scale});
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        _ResolveJob job = { dst, samples, r, scale };
+        Job_ParallelFor((U64)(r.Y1 - r.Y0), BMR_FILTER_ROW_GRAIN, _ResolveRows, &job);
+    }
+
+};  // namespace BMR
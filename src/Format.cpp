@@ -0,0 +1,307 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Format.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+
+#include "Format.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Simd.hpp"
+
+
+#define BMR_FORMAT_SCRATCH_PIXELS 256
+
+
+namespace BMR {
+
+    InternalFunc inline U16
+    _PackRGB565(const Color4 &c) noexcept
+    {
+        return (U16)(((c.R >> 3) << 11) | ((c.G >> 2) << 5) | (c.B >> 3));
+    }
+
+    InternalFunc inline Color4
+    _UnpackRGB565(U16 v) noexcept
+    {
+        U8 r = (v >> 11) & 0x1F;
+        U8 g = (v >> 5)  & 0x3F;
+        U8 b = (v >> 0)  & 0x1F;
+        return Color4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), MAX_U8);
+    }
+
+    InternalFunc inline U32
+    _SwapRB(U32 v) noexcept
+    {
+        U32 rb = v & 0x00FF00FF;
+        return (v & 0xFF00FF00) | (rb << 16) | (rb >> 16);
+    }
+
+    InternalFunc inline U8
+    _PackIndexed(const ColorPalette *p, const Color4 &c) noexcept
+    {
+        return p->Inverse[((c.R >> 3) << 10) | ((c.G >> 3) << 5) | (c.B >> 3)];
+    }
+
+    void 
+    Palette_Build(ColorPalette *p, const Color4 *colors, U32 count) noexcept
+    {
+        if (count > 256) {
+            count = 256;
+        }
+
+        for (U32 i = 0; i < 256; ++i) {
+            p->Colors[i] = i < count ? colors[i] : COLOR_BLACK;
+        }
+        p->Count = count;
+
+        if (count == 0) {
+            for (U8 &index : p->Inverse) {
+                index = 0;
+            }
+            return;
+        }
+
+        // NOTE(ilya.a): Brute force search is fine here, palette is changed 
+        // rarely and lookup must be cheap.
+        for (U32 key = 0; key < (1 << 15); ++key) {
+            S32 r = (((key >> 10) & 0x1F) << 3) | 4;
+            S32 g = (((key >> 5)  & 0x1F) << 3) | 4;
+            S32 b = (((key >> 0)  & 0x1F) << 3) | 4;
+
+            U32 bestIndex = 0;
+            U32 bestDistance = MAX_U32;
+
+            for (U32 i = 0; i < count; ++i) {
+                S32 dr = r - colors[i].R;
+                S32 dg = g - colors[i].G;
+                S32 db = b - colors[i].B;
+                U32 distance = dr * dr + dg * dg + db * db;
+
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex = i;
+                }
+            }
+
+            p->Inverse[key] = (U8)bestIndex;
+        }
+    }
+
+    void 
+    Palette_BuildDefault(ColorPalette *p) noexcept
+    {
+        Color4 colors[256];
+
+        for (U32 i = 0; i < 256; ++i) {
+            U32 r = (i >> 5) & 0x7;
+            U32 g = (i >> 2) & 0x7;
+            U32 b = (i >> 0) & 0x3;
+            colors[i] = Color4(r * MAX_U8 / 7, g * MAX_U8 / 7, b * MAX_U8 / 3, MAX_U8);
+        }
+
+        Palette_Build(p, colors, 256);
+    }
+
+    U32 
+    Format_Pack(const Surface *s, const Color4 &c) noexcept
+    {
+        switch (s->Format) {
+            case (PixelFormat::RGB565): {
+                return _PackRGB565(c);
+            } break;
+            case (PixelFormat::INDEXED8): {
+                return _PackIndexed(s->Palette, c);
+            } break;
+            case (PixelFormat::RGBA8888): {
+                return _SwapRB(*(const U32 *)&c);
+            } break;
+            case (PixelFormat::BGRA8888):
+            default: {
+                return *(const U32 *)&c;
+            } break;
+        }
+    }
+
+    InternalFunc void
+    _ExpandRGB565(const U16 *in, Color4 *out, S64 count) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const __m128i mask5 = _mm_set1_epi16(0x1F);
+        const __m128i mask6 = _mm_set1_epi16(0x3F);
+        const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+
+        for (; x + 8 <= count; x += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+
+            __m128i r = _mm_srli_epi16(v, 11);
+            __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+            __m128i b = _mm_and_si128(v, mask5);
+
+            r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+            g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+            b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+            // NOTE(ilya.a): Interleaving B|G and R|A halves gives BGRA.
+            __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+            __m128i ra = _mm_or_si128(r, alpha);
+
+            _mm_storeu_si128((__m128i *)(out + x + 0), _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128((__m128i *)(out + x + 4), _mm_unpackhi_epi16(bg, ra));
+        }
+#endif
+        for (; x < count; ++x) {
+            out[x] = _UnpackRGB565(in[x]);
+        }
+    }
+
+    /*
+     * SSE2 has no gather, so palette lookups are done by scalar loads, but
+     * they are packed four at a time and stored as whole vectors.
+     */
+    InternalFunc void
+    _ExpandIndexed(const U8 *in, const Color4 *colors, Color4 *out, S64 count) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const int *table = (const int *)colors;
+
+        for (; x + 8 <= count; x += 8) {
+            const U8 *i = in + x;
+            __m128i lo = _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+            __m128i hi = _mm_setr_epi32(table[i[4]], table[i[5]], table[i[6]], table[i[7]]);
+
+            _mm_storeu_si128((__m128i *)(out + x + 0), lo);
+            _mm_storeu_si128((__m128i *)(out + x + 4), hi);
+        }
+#endif
+        for (; x < count; ++x) {
+            out[x] = colors[in[x]];
+        }
+    }
+
+    /*
+     * Swaps red and blue of `count` pixels. `in` and `out` may be the same.
+     */
+    InternalFunc void
+    _SwizzleSpan(const U32 *in, U32 *out, S64 count) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+        const __m128i maskGA = _mm_set1_epi32((int)0xFF00FF00);
+
+        for (; x + 4 <= count; x += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+            __m128i rb = _mm_and_si128(v, maskRB);
+            __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+            _mm_storeu_si128((__m128i *)(out + x), _mm_or_si128(_mm_and_si128(v, maskGA), swapped));
+        }
+#endif
+        for (; x < count; ++x) {
+            out[x] = _SwapRB(in[x]);
+        }
+    }
+
+    void 
+    Format_LoadSpan(const Surface *s, S64 x, S64 y, 
+                    Color4 *out, S64 count) noexcept
+    {
+        const U8 *pixel = GetPixelAddress(s, x, y);
+
+        switch (s->Format) {
+            case (PixelFormat::RGB565): {
+                _ExpandRGB565((const U16 *)pixel, out, count);
+            } break;
+            case (PixelFormat::INDEXED8): {
+                _ExpandIndexed(pixel, s->Palette->Colors, out, count);
+            } break;
+            case (PixelFormat::RGBA8888): {
+                _SwizzleSpan((const U32 *)pixel, (U32 *)out, count);
+            } break;
+            case (PixelFormat::BGRA8888):
+            default: {
+                const Color4 *in = (const Color4 *)pixel;
+                for (S64 i = 0; i < count; ++i) {
+                    out[i] = in[i];
+                }
+            } break;
+        }
+    }
+
+    void 
+    Format_StoreSpan(Surface *s, S64 x, S64 y, 
+                     const Color4 *in, S64 count) noexcept
+    {
+        U8 *pixel = GetPixelAddress(s, x, y);
+
+        switch (s->Format) {
+            case (PixelFormat::RGB565): {
+                U16 *out = (U16 *)pixel;
+                for (S64 i = 0; i < count; ++i) {
+                    out[i] = _PackRGB565(in[i]);
+                }
+            } break;
+            case (PixelFormat::INDEXED8): {
+                for (S64 i = 0; i < count; ++i) {
+                    pixel[i] = _PackIndexed(s->Palette, in[i]);
+                }
+            } break;
+            case (PixelFormat::RGBA8888): {
+                _SwizzleSpan((const U32 *)in, (U32 *)pixel, count);
+            } break;
+            case (PixelFormat::BGRA8888):
+            default: {
+                Color4 *out = (Color4 *)pixel;
+                for (S64 i = 0; i < count; ++i) {
+                    out[i] = in[i];
+                }
+            } break;
+        }
+    }
+
+    void 
+    Format_Convert(const Surface *src, Surface *dst, bool isFlipped) noexcept
+    {
+        if (src->Buffer == nullptr || dst->Buffer == nullptr) {
+            return;
+        }
+
+        U64 width  = src->Width  < dst->Width  ? src->Width  : dst->Width;
+        U64 height = src->Height < dst->Height ? src->Height : dst->Height;
+
+        for (U64 y = 0; y < height; ++y) {
+            S64 srcY = src->Y + (S64)y;
+            S64 dstY = dst->Y + (S64)(isFlipped ? height - 1 - y : y);
+            U8 *out = GetPixelAddress(dst, dst->X, dstY);
+
+            // NOTE(ilya.a): Rows are converted right into destination, only
+            // conversion between two compact formats goes through `Color4`.
+            if (src->Format == dst->Format) {
+                memcpy(out, GetPixelAddress(src, src->X, srcY), width * GetBytesPerPixel(src->Format));
+            } else if (dst->Format == PixelFormat::BGRA8888) {
+                Format_LoadSpan(src, src->X, srcY, (Color4 *)out, (S64)width);
+            } else if (src->Format == PixelFormat::BGRA8888) {
+                Format_StoreSpan(dst, dst->X, dstY, (const Color4 *)GetPixelAddress(src, src->X, srcY), (S64)width);
+            } else {
+                Color4 scratch[BMR_FORMAT_SCRATCH_PIXELS];
+                for (U64 x = 0; x < width; x += BMR_FORMAT_SCRATCH_PIXELS) {
+                    S64 count = (S64)(width - x < BMR_FORMAT_SCRATCH_PIXELS ? width - x : BMR_FORMAT_SCRATCH_PIXELS);
+                    Format_LoadSpan(src, src->X + (S64)x, srcY, scratch, count);
+                    Format_StoreSpan(dst, dst->X + (S64)x, dstY, scratch, count);
+                }
+            }
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,61 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Format.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Conversions between `Color4` and pixel formats of surfaces.
+ * */
+
+#ifndef SBMR_FORMAT_HPP_INCLUDED
+#define SBMR_FORMAT_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+
+
+namespace BMR {
+
+    /*
+     * Fills palette with `count` colors and rebuilds inverse lookup table.
+     */
+    void Palette_Build(ColorPalette *p, const Color4 *colors, U32 count) noexcept;
+
+    /*
+     * Fills palette with 3-3-2 RGB cube.
+     */
+    void Palette_BuildDefault(ColorPalette *p) noexcept;
+
+    /*
+     * Converts color into pixel value of surface's format.
+     */
+    U32 Format_Pack(const Surface *s, const Color4 &c) noexcept;
+
+    /*
+     * Reads `count` pixels from row `y` starting at `x`, converting them
+     * into `Color4`.
+     */
+    void Format_LoadSpan(const Surface *s, S64 x, S64 y, 
+                         Color4 *out, S64 count) noexcept;
+
+    /*
+     * Writes `count` colors into row `y` starting at `x`, converting them
+     * into surface's format.
+     */
+    void Format_StoreSpan(Surface *s, S64 x, S64 y, 
+                          const Color4 *in, S64 count) noexcept;
+
+    /*
+     * Converts whole `src` into `dst` of same size. Rows are reversed, if
+     * `isFlipped`. Rows of the same format are copied, `BGRA8888` and
+     * `RGBA8888` are swizzled by SIMD.
+     */
+    void Format_Convert(const Surface *src, Surface *dst, bool isFlipped) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_FORMAT_HPP_INCLUDED
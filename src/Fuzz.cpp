@@ -0,0 +1,473 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Fuzz.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Differential fuzzer. Renders random command streams with optimized
+ * rasterizer (queue optimizer included) and with reference one, and
+ * reports first pixel, where they differ. Tile cache of backbuffer is
+ * checked by rendering a frame and then its mutated copy, sparse canvas
+ * by rendering the same commands into it and presenting it.
+ *
+ * Usage: sbmr-fuzz [iterations] [seed]
+ *
+ * Each iteration is seeded separately, so failing one is reproduced with
+ * `sbmr-fuzz 1 <seed printed in report>`.
+ * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Lin.hpp"
+#include "Surface.hpp"
+#include "Command.hpp"
+#include "Reference.hpp"
+#include "BMR.hpp"
+
+
+#define FUZZ_MAX_SIZE     300
+#define FUZZ_MAX_COMMANDS 48
+
+
+/*
+ * xorshift64*.
+ */
+GlobalVar U64 rngState;
+
+// NOTE(ilya.a): Pixels of reference, which may go either way, see
+// `Reference_Rasterize`.
+GlobalVar U8 ambiguous[FUZZ_MAX_SIZE * FUZZ_MAX_SIZE];
+
+InternalFunc U64
+Fuzz_Next()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+InternalFunc U32
+Fuzz_Below(U32 n)
+{
+    return (U32)(Fuzz_Next() % n);
+}
+
+InternalFunc Color4
+Fuzz_Color()
+{
+    U32 v = (U32)Fuzz_Next();
+    return Color4((U8)(v >> 16), (U8)(v >> 8), (U8)v, (U8)(v >> 24));
+}
+
+/*
+ * Coordinate along axis of `size` pixels. Mostly on surface, but edges
+ * and values, which are overflowing, are picked a lot more often, than
+ * uniform distribution would.
+ */
+InternalFunc U32
+Fuzz_Coord(U32 size, U32 max)
+{
+    switch (Fuzz_Below(10)) {
+        case 0:  return 0;
+        case 1:  return size - 1;
+        case 2:  return size;
+        case 3:  return size + 1 + Fuzz_Below(16);
+        case 4:  return max - Fuzz_Below(4);
+        case 5:  return Fuzz_Below(max);
+        default: return Fuzz_Below(size + 1);
+    }
+}
+
+InternalFunc U32
+Fuzz_Size()
+{
+    PersistVar const U32 EDGES[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65 };
+
+    if (Fuzz_Below(2) == 0) {
+        return EDGES[Fuzz_Below(sizeof(EDGES) / sizeof(EDGES[0]))];
+    }
+    return 1 + Fuzz_Below(FUZZ_MAX_SIZE);
+}
+
+InternalFunc void
+Fuzz_PushCommands(U32 w, U32 h)
+{
+    U32 count = 1 + Fuzz_Below(FUZZ_MAX_COMMANDS);
+
+    for (U32 i = 0; i < count; ++i) {
+        switch (Fuzz_Below(6)) {
+            case 0: {
+                BMR::SetClearColor(Fuzz_Color());
+                BMR::Clear();
+            } break;
+            case 1: {
+                BMR::DrawRect(
+                    Fuzz_Coord(w, MAX_U16), Fuzz_Coord(h, MAX_U16),
+                    Fuzz_Coord(w, MAX_U16), Fuzz_Coord(h, MAX_U16),
+                    Fuzz_Color());
+            } break;
+            case 2: {
+                BMR::DrawGrad((U32)Fuzz_Next(), (U32)Fuzz_Next());
+            } break;
+            case 3: {
+                BMR::SetLineMode(
+                    Fuzz_Below(2) == 0 ? BMR::LineMode::ALIASED : BMR::LineMode::ANTIALIASED);
+                BMR::DrawLine(
+                    Fuzz_Coord(w, MAX_U32), Fuzz_Coord(h, MAX_U32),
+                    Fuzz_Coord(w, MAX_U32), Fuzz_Coord(h, MAX_U32),
+                    Fuzz_Color());
+            } break;
+            case 4: {
+                // NOTE(ilya.a): Rect split in two, which queue optimizer
+                // is expected to merge back. Often covers whole surface.
+                bool isFull = Fuzz_Below(3) == 0;
+                U32 x = isFull ? 0 : Fuzz_Below(w);
+                U32 y = isFull ? 0 : Fuzz_Below(h);
+                U32 rw = isFull ? w : 1 + Fuzz_Below(w);
+                U32 rh = isFull ? h : 1 + Fuzz_Below(h);
+                Color4 c = Fuzz_Color();
+
+                if (Fuzz_Below(2) == 0) {
+                    U32 split = Fuzz_Below(rw + 1);
+                    BMR::DrawRect(x, y, split, rh, c);
+                    BMR::DrawRect(x + split, y, rw - split, rh, c);
+                } else {
+                    U32 split = Fuzz_Below(rh + 1);
+                    BMR::DrawRect(x, y, rw, split, c);
+                    BMR::DrawRect(x, y + split, rw, rh - split, c);
+                }
+            } break;
+            case 5: {
+                // NOTE(ilya.a): Rect rotated and scaled around a point on
+                // surface. Sometimes by multiple of 90 degrees, so it
+                // stays a rect.
+                F64 angle = Fuzz_Below(4) == 0 
+                    ? (F64)Fuzz_Below(4) * M_PI / 2 : (F64)Fuzz_Below(3600) * M_PI / 1800;
+                F64 scale = 0.25 + (F64)Fuzz_Below(16) / 4;
+
+                BMR::PushTransform(Transform::Translation(Fuzz_Below(w + 1), Fuzz_Below(h + 1)));
+                BMR::PushTransform(Transform::Rotation(angle));
+                BMR::PushTransform(Transform::Scaling(scale, Fuzz_Below(2) == 0 ? scale : -scale));
+                BMR::DrawRect(Fuzz_Below(w), Fuzz_Below(h), Fuzz_Size(), Fuzz_Size(), Fuzz_Color());
+                BMR::PopTransform();
+                BMR::PopTransform();
+                BMR::PopTransform();
+            } break;
+        }
+    }
+}
+
+InternalFunc void
+Fuzz_PrintCommands(const U8 *cursor, U64 count)
+{
+    for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+        BMR::RenderCommandType type = *((const BMR::RenderCommandType *)cursor);
+
+        switch (type) {
+            case (BMR::RenderCommandType::CLEAR): {
+                auto *command = (const BMR::RenderCommand<Color4> *)cursor;
+                U32 c;
+                memcpy(&c, &command->Payload, sizeof(c));
+                printf("  %3llu CLEAR    %08x\n", commandIdx, c);
+            } break;
+            case (BMR::RenderCommandType::RECT): {
+                auto *command = (const BMR::RenderCommand<BMR::_DrawRect_Payload> *)cursor;
+                const Rect &r = command->Payload.Rect;
+                U32 c;
+                memcpy(&c, &command->Payload.Color, sizeof(c));
+                printf("  %3llu RECT     x=%u y=%u w=%u h=%u %08x\n",
+                       commandIdx, r.X, r.Y, r.Width, r.Height, c);
+            } break;
+            case (BMR::RenderCommandType::QUAD): {
+                auto *command = (const BMR::RenderCommand<BMR::_DrawQuad_Payload> *)cursor;
+                const Rect &r = command->Payload.Rect;
+                const Transform &t = command->Payload.Transform;
+                U32 c;
+                memcpy(&c, &command->Payload.Color, sizeof(c));
+                printf("  %3llu QUAD     x=%u y=%u w=%u h=%u %08x [%d %d %d %d %lld %lld]\n",
+                       commandIdx, r.X, r.Y, r.Width, r.Height, c, t.A, t.B, t.C, t.D, t.X, t.Y);
+            } break;
+            case (BMR::RenderCommandType::GRADIENT): {
+                auto *command = (const BMR::RenderCommand<Vec2u> *)cursor;
+                printf("  %3llu GRADIENT x=%u y=%u\n",
+                       commandIdx, command->Payload.X, command->Payload.Y);
+            } break;
+            case (BMR::RenderCommandType::LINE): {
+                auto *command = (const BMR::RenderCommand<BMR::_DrawLine_Payload> *)cursor;
+                const BMR::_DrawLine_Payload &p = command->Payload;
+                U32 c;
+                memcpy(&c, &p.Color, sizeof(c));
+                printf("  %3llu LINE     (%u, %u) -> (%u, %u) %08x %s\n",
+                       commandIdx, p.p1.X, p.p1.Y, p.p2.X, p.p2.Y, c,
+                       p.Mode == BMR::LineMode::ANTIALIASED ? "antialiased" : "aliased");
+            } break;
+            default: {
+                printf("  %3llu ???\n", commandIdx);
+            } break;
+        }
+
+        cursor += BMR::Command_GetSize(type);
+    }
+}
+
+/*
+ * Returns `false` and prints report, if surfaces differ in any pixel, which
+ * is not marked in `ambiguous`.
+ */
+InternalFunc bool
+Fuzz_Compare(const Surface *expected, const Surface *actual, U64 seed,
+             const U8 *commands, U64 count)
+{
+    for (U64 y = 0; y < expected->Height; ++y) {
+        const U32 *e = (const U32 *)((const U8 *)expected->Buffer + y * expected->Pitch);
+        const U32 *a = (const U32 *)((const U8 *)actual->Buffer + y * actual->Pitch);
+
+        for (U64 x = 0; x < expected->Width; ++x) {
+            if (e[x] == a[x] || ambiguous[y * expected->Width + x]) {
+                continue;
+            }
+
+            printf("MISMATCH seed=%llu size=%llux%llu\n", seed, expected->Width, expected->Height);
+            printf("  pixel (%llu, %llu): expected %08x, got %08x\n", x, y, e[x], a[x]);
+            Fuzz_PrintCommands(commands, count);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Renders `commands` into backbuffer with tile cache and compares it with
+ * reference.
+ */
+InternalFunc bool
+Fuzz_RenderTiled(const U8 *commands, Size size, U64 count, U64 seed)
+{
+    Surface *backbuffer = BMR::GetBackbuffer();
+    Surface *expected = BMR::CreateTarget((U32)backbuffer->Width, (U32)backbuffer->Height);
+    if (expected == nullptr) {
+        return false;
+    }
+
+    BMR::Reference_Rasterize(expected, commands, size, count, ambiguous);
+
+    BMR::SubmitCommands(commands, size, count);
+    BMR::BeginDrawing(backbuffer);
+    BMR::EndDrawing();
+
+    bool isSame = Fuzz_Compare(expected, backbuffer, seed, commands, count);
+    BMR::DestroyTarget(expected);
+    return isSame;
+}
+
+/*
+ * Frame, which starts with clear, then the same frame with one command
+ * removed or one rect added, then the first frame again.
+ */
+InternalFunc bool
+Fuzz_CheckTiles(U32 w, U32 h, U64 seed)
+{
+    PersistVar U8 first[BMR_RENDER_COMMAND_CAPACITY];
+    PersistVar U8 second[BMR_RENDER_COMMAND_CAPACITY];
+
+    BMR::Resize((S32)w, (S32)h);
+    BMR::SetTileCache(true);
+
+    BMR::SetClearColor(Fuzz_Color());
+    BMR::Clear();
+    Fuzz_PushCommands(w, h);
+
+    const void *queue = nullptr;
+    Size size = 0;
+    U64 count = 0;
+    BMR::GetCommands(&queue, &size, &count);
+    memcpy(first, queue, size);
+    BMR::DiscardCommands();
+
+    memcpy(second, first, size);
+    Size secondSize = size;
+    U64 secondCount = count;
+
+    if (count > 1 && Fuzz_Below(2) == 0) {
+        // NOTE(ilya.a): Command is replaced with NOPs of the same size.
+        U64 removed = 1 + Fuzz_Below((U32)count - 1);
+        U8 *cursor = second;
+        for (U64 commandIdx = 0; commandIdx < removed; ++commandIdx) {
+            cursor += BMR::Command_GetSize(*((BMR::RenderCommandType *)cursor));
+        }
+
+        Size commandSize = BMR::Command_GetSize(*((BMR::RenderCommandType *)cursor));
+        Size nopSize = BMR::Command_GetSize(BMR::RenderCommandType::NOP);
+        memset(cursor, 0, commandSize);
+        for (Size i = 0; i < commandSize; i += nopSize) {
+            BMR::RenderCommandType nop = BMR::RenderCommandType::NOP;
+            memcpy(cursor + i, &nop, sizeof(nop));
+        }
+        secondCount += commandSize / nopSize - 1;
+    } else {
+        BMR::DrawRect(Fuzz_Below(w), Fuzz_Below(h), Fuzz_Size(), Fuzz_Size(), Fuzz_Color());
+        BMR::GetCommands(&queue, &size, &count);
+        memcpy(second + secondSize, queue, size);
+        secondSize += size;
+        secondCount += count;
+        BMR::DiscardCommands();
+
+        size = secondSize - size;
+        count = secondCount - count;
+    }
+
+    bool isSame = Fuzz_RenderTiled(first, size, count, seed)
+        && Fuzz_RenderTiled(second, secondSize, secondCount, seed)
+        && Fuzz_RenderTiled(first, size, count, seed);
+
+    BMR::SetTileCache(false);
+    return isSame;
+}
+
+/*
+ * Canvas starts as `background`, which is also filled into reference.
+ * `GRADIENT` is skipped by canvas, so such streams are not checked.
+ */
+InternalFunc bool
+Fuzz_CheckCanvas(U32 w, U32 h, U64 seed, const U8 *commands, Size size, U64 count)
+{
+    const U8 *cursor = commands;
+    for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+        BMR::RenderCommandType type = *((const BMR::RenderCommandType *)cursor);
+        if (type == BMR::RenderCommandType::GRADIENT) {
+            return true;
+        }
+        cursor += BMR::Command_GetSize(type);
+    }
+
+    Color4 background = Fuzz_Color();
+    BMR::Canvas *canvas = BMR::CreateCanvas(w, h, background);
+    Surface *expected = BMR::CreateTarget(w, h);
+    Surface *actual = BMR::CreateTarget(w, h);
+    if (canvas == nullptr || expected == nullptr || actual == nullptr) {
+        return false;
+    }
+
+    BMR::BeginDrawing(expected);
+    BMR::SetClearColor(background);
+    BMR::Clear();
+    BMR::EndDrawing();
+    BMR::Reference_Rasterize(expected, commands, size, count, ambiguous);
+
+    BMR::SubmitCommands(commands, size, count);
+    BMR::BeginDrawing(canvas);
+    BMR::EndDrawing();
+
+    BMR::DrawCanvas(canvas, Rect(0, 0, w, h), 0, 0);
+    BMR::BeginDrawing(actual);
+    BMR::EndDrawing();
+
+    bool isSame = Fuzz_Compare(expected, actual, seed, commands, count);
+
+    BMR::DestroyTarget(actual);
+    BMR::DestroyTarget(expected);
+    BMR::DestroyCanvas(canvas);
+    return isSame;
+}
+
+/*
+ * Parses decimal argument. Rejects empty, signed and partially numeric
+ * ones, so typo is not silently turned into zero iterations.
+ * */
+InternalFunc bool
+Fuzz_ParseArg(const char *arg, Out U64 *value)
+{
+    if (arg[0] < '0' || arg[0] > '9') {
+        return false;
+    }
+
+    char *end = nullptr;
+    errno = 0;
+    *value = strtoull(arg, &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    U64 iterations = 1000;
+    U64 seed = 1;
+
+    if (argc > 3
+        || (argc > 1 && !Fuzz_ParseArg(argv[1], &iterations))
+        || (argc > 2 && !Fuzz_ParseArg(argv[2], &seed))) {
+        fprintf(stderr, "Usage: %s [iterations] [seed]\n", argv[0]);
+        return 2;
+    }
+
+    PersistVar U8 commands[BMR_RENDER_COMMAND_CAPACITY];
+
+    BMR::Init();
+
+    U64 failures = 0;
+    for (U64 iteration = 0; iteration < iterations; ++iteration) {
+        U64 iterationSeed = seed + iteration;
+        rngState = iterationSeed * 0x9E3779B97F4A7C15ULL + 1;
+
+        U32 w = Fuzz_Size();
+        U32 h = Fuzz_Size();
+
+        Surface *actual = BMR::CreateTarget(w, h);
+        Surface *expected = BMR::CreateTarget(w, h);
+        if (actual == nullptr || expected == nullptr) {
+            return 2;
+        }
+
+        // NOTE(ilya.a): Pixels, which are not covered by any command,
+        // must be left as they are, so both start from same garbage.
+        for (U64 y = 0; y < h; ++y) {
+            U32 *a = (U32 *)((U8 *)actual->Buffer + y * actual->Pitch);
+            U32 *e = (U32 *)((U8 *)expected->Buffer + y * expected->Pitch);
+
+            for (U64 x = 0; x < w; ++x) {
+                a[x] = e[x] = (U32)Fuzz_Next();
+            }
+        }
+
+        Fuzz_PushCommands(w, h);
+
+        const void *queue = nullptr;
+        Size size = 0;
+        U64 count = 0;
+        BMR::GetCommands(&queue, &size, &count);
+        memcpy(commands, queue, size);
+
+        BMR::Reference_Rasterize(expected, commands, size, count, ambiguous);
+
+        BMR::BeginDrawing(actual);
+        BMR::EndDrawing();
+
+        if (!Fuzz_Compare(expected, actual, iterationSeed, commands, count)) {
+            failures++;
+        } else if (!Fuzz_CheckCanvas(w, h, iterationSeed, commands, size, count)) {
+            failures++;
+        } else if (!Fuzz_CheckTiles(w, h, iterationSeed)) {
+            failures++;
+        }
+
+        BMR::DestroyTarget(expected);
+        BMR::DestroyTarget(actual);
+    }
+
+    BMR::DeInit();
+
+    printf("%llu iterations, %llu failed\n", iterations, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Gamma.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Gamma.hpp"
+
+#include <math.h>
+
+#include "Types.hpp"
+
+
+namespace BMR {
+
+    U16 Gamma_ToLinear[256];
+    U8  Gamma_ToSRGB[BMR_GAMMA_LINEAR_MAX + 1];
+
+    void 
+    Gamma_Init() noexcept
+    {
+        for (U32 i = 0; i < 256; ++i) {
+            F64 c = i / 255.0;
+            F64 l = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+            Gamma_ToLinear[i] = (U16)(l * BMR_GAMMA_LINEAR_MAX + 0.5);
+        }
+
+        for (U32 i = 0; i <= BMR_GAMMA_LINEAR_MAX; ++i) {
+            F64 l = (F64)i / BMR_GAMMA_LINEAR_MAX;
+            F64 c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+            Gamma_ToSRGB[i] = (U8)(c * 255.0 + 0.5);
+        }
+    }
+
+};  // namespace BMR
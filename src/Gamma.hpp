@@ -0,0 +1,87 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Gamma.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Lookup tables for blending in linear light. Colors are stored in sRGB,
+ * but partially covered pixels must be mixed linearly, otherwise
+ * anti-aliased edges look thin and dark.
+ * */
+
+#ifndef SBMR_GAMMA_HPP_INCLUDED
+#define SBMR_GAMMA_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Simd.hpp"
+
+
+// NOTE(ilya.a): 12 bits of linear precision are enough to not lose any of
+// dark sRGB values on round trip.
+#define BMR_GAMMA_LINEAR_BITS 12
+#define BMR_GAMMA_LINEAR_MAX ((1 << BMR_GAMMA_LINEAR_BITS) - 1)
+
+
+namespace BMR {
+
+    extern U16 Gamma_ToLinear[256];
+    extern U8  Gamma_ToSRGB[BMR_GAMMA_LINEAR_MAX + 1];
+
+    /*
+     * Fills lookup tables. Must be called before any blending is done.
+     */
+    void Gamma_Init() noexcept;
+
+    /*
+     * Color with channels already converted to linear light, so blending
+     * many pixels with the same color does only half of lookups.
+     */
+    struct LinearColor {
+        U16 R;
+        U16 G;
+        U16 B;
+        U8  A;
+    };
+
+    inline LinearColor
+    Gamma_ToLinearColor(const Color4 &c) noexcept
+    {
+        return LinearColor{
+            Gamma_ToLinear[c.R], Gamma_ToLinear[c.G], Gamma_ToLinear[c.B], c.A};
+    }
+
+    inline U8
+    Gamma_Blend8(U8 d, U32 ls, U8 coverage) noexcept
+    {
+        U32 ld = Gamma_ToLinear[d];
+        U32 l  = (ls * coverage + ld * (MAX_U8 - coverage) + 127) / MAX_U8;
+        return Gamma_ToSRGB[l];
+    }
+
+    /*
+     * Blends `s` over `d` by `coverage` in linear light. Alpha channel is
+     * not gamma encoded, so it's mixed as is.
+     */
+    inline Color4
+    Gamma_Blend(Color4 d, const LinearColor &s, U8 coverage) noexcept
+    {
+        return Color4(
+            Gamma_Blend8(d.R, s.R, coverage),
+            Gamma_Blend8(d.G, s.G, coverage),
+            Gamma_Blend8(d.B, s.B, coverage),
+            (U8)(Mul8(s.A, coverage) + Mul8(d.A, MAX_U8 - coverage)));
+    }
+
+    inline Color4
+    Gamma_Blend(Color4 d, Color4 s, U8 coverage) noexcept
+    {
+        return Gamma_Blend(d, Gamma_ToLinearColor(s), coverage);
+    }
+
+};  // namespace BMR
+
+#endif  // SBMR_GAMMA_HPP_INCLUDED
@@ -14,29 +14,30 @@
 
 #include "Types.hpp"
 
+// NOTE(ilya.a): Coordinates are 32-bit, so rects can address any pixel
+// of canvas. Right and bottom edges are computed in 64 bits.
 struct Rect {
-    U16 X;
-    U16 Y;
-    U16 Width;
-    U16 Height;
+    U32 X;
+    U32 Y;
+    U32 Width;
+    U32 Height;
 
-    constexpr Rect(U16 x = 0, U16 y = 0, U16 width = 0, U16 height = 0) noexcept 
+    constexpr Rect(U32 x = 0, U32 y = 0, U32 width = 0, U32 height = 0) noexcept 
         : X(x), Y(y), Width(width), Height(height)
     { }
 
-    constexpr bool IsInside(U16 x, U16 y) const noexcept
+    // NOTE(ilya.a): Rect covers `Width` x `Height` pixels, so right and
+    // bottom edges are excluded. Rasterizer fills exactly these pixels.
+    constexpr bool IsInside(U32 x, U32 y) const noexcept
     {
-        return x >= X && x <= X + Width && y >= Y && y <= Y + Height;
+        return x >= X && x < (U64)X + Width && y >= Y && y < (U64)Y + Height;
     }
 
 
-    // TODO(ilya.a): Fix bug when `r` is bigger than `this`.
     constexpr bool IsOverlapping(const Rect &r) const noexcept
     {
-        return IsInside(r.X + 0      , r.Y + 0) 
-            || IsInside(r.X + r.Width, r.Y + r.Height)
-            || IsInside(r.X + r.Width, r.Y + 0)
-            || IsInside(r.X + 0      , r.Y + r.Height);
+        return r.X < (U64)X + Width  && X < (U64)r.X + r.Width
+            && r.Y < (U64)Y + Height && Y < (U64)r.Y + r.Height;
     }
 };
 
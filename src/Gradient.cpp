@@ -0,0 +1,312 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Gradient.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Linear and radial gradients.
+ *
+ * Colors are baked into 256 entry lookup table once per command. Each
+ * pixel is then only computing its position `t` in 16.16 fixed point, 
+ * four pixels at once, and looking color up.
+ * */
+
+#include <math.h>
+#include <string.h>
+
+#include "Raster.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Format.hpp"
+#include "Simd.hpp"
+
+
+#define BMR_GRADIENT_LUT_SIZE 256
+#define BMR_GRADIENT_CHUNK 256
+
+// NOTE(ilya.a): Linear gradient position is recomputed exactly every
+// few pixels, so error of fixed point stepping is not accumulated.
+#define BMR_GRADIENT_STEP_RUN 16
+
+#define BMR_GRADIENT_ONE (1 << 16)
+
+
+namespace BMR {
+
+    InternalFunc void
+    _BuildLUT(const Gradient &g, Color4 *lut) noexcept
+    {
+        U32 count = g.StopCount < BMR_GRADIENT_MAX_STOPS ? g.StopCount : BMR_GRADIENT_MAX_STOPS;
+
+        if (count == 0) {
+            for (U32 i = 0; i < BMR_GRADIENT_LUT_SIZE; ++i) {
+                lut[i] = COLOR_BLACK;
+            }
+            return;
+        }
+
+        U32 stop = 0;
+        for (U32 i = 0; i < BMR_GRADIENT_LUT_SIZE; ++i) {
+            F32 t = (i + 0.5f) / BMR_GRADIENT_LUT_SIZE;
+
+            while (stop < count && g.Stops[stop].Offset <= t) {
+                ++stop;
+            }
+
+            if (stop == 0) {
+                lut[i] = g.Stops[0].Color;
+            } else if (stop == count) {
+                lut[i] = g.Stops[count - 1].Color;
+            } else {
+                const GradientStop &a = g.Stops[stop - 1];
+                const GradientStop &b = g.Stops[stop];
+                F32 span = b.Offset - a.Offset;
+                U8 w = span > 0 ? (U8)((t - a.Offset) / span * MAX_U8 + 0.5f) : MAX_U8;
+
+                lut[i] = Color4(
+                    Mul8(a.Color.R, MAX_U8 - w) + Mul8(b.Color.R, w),
+                    Mul8(a.Color.G, MAX_U8 - w) + Mul8(b.Color.G, w),
+                    Mul8(a.Color.B, MAX_U8 - w) + Mul8(b.Color.B, w),
+                    Mul8(a.Color.A, MAX_U8 - w) + Mul8(b.Color.A, w));
+            }
+        }
+    }
+
+    InternalFunc inline U32
+    _GetIndex(S32 t, GradientSpread spread) noexcept
+    {
+        switch (spread) {
+            case (GradientSpread::REPEAT): {
+                return (U32)(t >> 8) & 0xFF;
+            } break;
+            case (GradientSpread::REFLECT): {
+                U32 u = (U32)t & 0x1FFFF;
+                if (u > 0xFFFF) {
+                    u = 0x1FFFF - u;
+                }
+                return u >> 8;
+            } break;
+            case (GradientSpread::CLAMP):
+            default: {
+                if (t < 0) t = 0;
+                if (t > 0xFFFF) t = 0xFFFF;
+                return (U32)t >> 8;
+            } break;
+        }
+    }
+
+#if BMR_SIMD_SSE2
+    InternalFunc inline __m128i
+    _Select(__m128i mask, __m128i a, __m128i b) noexcept
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    InternalFunc inline __m128i
+    _GetIndex4(__m128i t, GradientSpread spread) noexcept
+    {
+        const __m128i max = _mm_set1_epi32(0xFFFF);
+
+        switch (spread) {
+            case (GradientSpread::REPEAT): {
+                return _mm_and_si128(_mm_srai_epi32(t, 8), _mm_set1_epi32(0xFF));
+            } break;
+            case (GradientSpread::REFLECT): {
+                const __m128i period = _mm_set1_epi32(0x1FFFF);
+                __m128i u = _mm_and_si128(t, period);
+                u = _Select(_mm_cmpgt_epi32(u, max), _mm_sub_epi32(period, u), u);
+                return _mm_srli_epi32(u, 8);
+            } break;
+            case (GradientSpread::CLAMP):
+            default: {
+                t = _mm_and_si128(t, _mm_cmpgt_epi32(t, _mm_setzero_si128()));
+                t = _Select(_mm_cmpgt_epi32(t, max), max, t);
+                return _mm_srli_epi32(t, 8);
+            } break;
+        }
+    }
+#endif
+
+    /*
+     * Brings position closer to zero, without changing resulting color, so
+     * stepping from it doesn't overflow 32 bits.
+     */
+    InternalFunc inline S32
+    _Reduce(F64 t, GradientSpread spread) noexcept
+    {
+        switch (spread) {
+            case (GradientSpread::REPEAT): {
+                return (S32)(t - floor(t / BMR_GRADIENT_ONE) * BMR_GRADIENT_ONE);
+            } break;
+            case (GradientSpread::REFLECT): {
+                return (S32)(t - floor(t / (2 * BMR_GRADIENT_ONE)) * (2 * BMR_GRADIENT_ONE));
+            } break;
+            case (GradientSpread::CLAMP):
+            default: {
+                // NOTE(ilya.a): Far enough, that run of steps from the limit
+                // stays on the same side of the range.
+                const F64 limit = (BMR_GRADIENT_STEP_RUN + 2.0) * BMR_GRADIENT_ONE;
+                return (S32)(t < -limit ? -limit : (t > limit ? limit : t));
+            } break;
+        }
+    }
+
+    InternalFunc void
+    _LinearIndices(const Gradient &g, F64 x, F64 y, 
+                   U32 *indices, S64 count) noexcept
+    {
+        F64 dx = (F64)g.End.X - g.Start.X;
+        F64 dy = (F64)g.End.Y - g.Start.Y;
+        F64 length2 = dx * dx + dy * dy;
+
+        // NOTE(ilya.a): Step is bounded by one period per pixel, so run of
+        // `BMR_GRADIENT_STEP_RUN` pixels can't overflow after `_Reduce`.
+        F64 scale = BMR_GRADIENT_ONE / length2;
+        S32 step = (S32)(dx * scale + (dx >= 0 ? 0.5 : -0.5));
+        F64 rowT = ((y + 0.5 - g.Start.Y) * dy) * scale;
+
+        // NOTE(ilya.a): Position is computed exactly at every multiple of
+        // `BMR_GRADIENT_STEP_RUN` and stepped from there, so pixel gets the
+        // same color wherever span, which contains it, begins.
+        S64 n = 0;
+        for (S64 run = 0; run < count; run += n) {
+            S64 runX = (S64)x + run;
+            S64 anchor = runX - runX % BMR_GRADIENT_STEP_RUN;
+
+            n = anchor + BMR_GRADIENT_STEP_RUN - runX;
+            n = count - run < n ? count - run : n;
+
+            S32 t = _Reduce(rowT + (anchor + 0.5 - g.Start.X) * dx * scale, g.Spread) 
+                  + (S32)(runX - anchor) * step;
+
+            S64 i = 0;
+#if BMR_SIMD_SSE2
+            __m128i tv = _mm_setr_epi32(t, t + step, t + 2 * step, t + 3 * step);
+            const __m128i step4 = _mm_set1_epi32(4 * step);
+
+            for (; i + 4 <= n; i += 4) {
+                _mm_storeu_si128((__m128i *)(indices + run + i), _GetIndex4(tv, g.Spread));
+                tv = _mm_add_epi32(tv, step4);
+            }
+#endif
+            for (; i < n; ++i) {
+                indices[run + i] = _GetIndex(t + (S32)i * step, g.Spread);
+            }
+        }
+    }
+
+    InternalFunc void
+    _RadialIndices(const Gradient &g, F64 x, F64 y, 
+                   U32 *indices, S64 count) noexcept
+    {
+        F64 rx = (F64)g.End.X - g.Start.X;
+        F64 ry = (F64)g.End.Y - g.Start.Y;
+
+        // NOTE(ilya.a): Distances are computed in F32, with clamping, so
+        // conversion to 16.16 never overflows.
+        const F32 scale = (F32)(BMR_GRADIENT_ONE / sqrt(rx * rx + ry * ry));
+        const F32 limit = (F32)(1 << 30);
+        const F32 dy = (F32)(y + 0.5 - g.Start.Y);
+        const F32 dy2 = dy * dy;
+        const F32 x0 = (F32)(x + 0.5 - g.Start.X);
+
+        S64 i = 0;
+#if BMR_SIMD_SSE2
+        __m128 xs = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(0, 1, 2, 3));
+        const __m128 step = _mm_set1_ps(4);
+        const __m128 dy2v = _mm_set1_ps(dy2);
+        const __m128 scalev = _mm_set1_ps(scale);
+        const __m128 limitv = _mm_set1_ps(limit);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(xs, xs), dy2v);
+            __m128 t = _mm_min_ps(_mm_mul_ps(_mm_sqrt_ps(d2), scalev), limitv);
+            _mm_storeu_si128((__m128i *)(indices + i), _GetIndex4(_mm_cvttps_epi32(t), g.Spread));
+            xs = _mm_add_ps(xs, step);
+        }
+#endif
+        for (; i < count; ++i) {
+            F32 xs = x0 + (F32)i;
+            F32 t = sqrtf(xs * xs + dy2) * scale;
+            indices[i] = _GetIndex((S32)(t < limit ? t : limit), g.Spread);
+        }
+    }
+
+    void 
+    Raster_GradientEx(Surface *dst, const Clip &clip, 
+                      const Clip &area, const Gradient &g) noexcept
+    {
+        Clip r = area.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        Color4 lut[BMR_GRADIENT_LUT_SIZE];
+        _BuildLUT(g, lut);
+
+        bool isDegenerate = g.Start.X == g.End.X && g.Start.Y == g.End.Y;
+        if (isDegenerate) {
+            U32 last = g.StopCount < BMR_GRADIENT_MAX_STOPS ? g.StopCount : BMR_GRADIENT_MAX_STOPS;
+            Raster_Fill(dst, clip, area, last > 0 ? g.Stops[last - 1].Color : COLOR_BLACK);
+            return;
+        }
+
+        U32 indices[BMR_GRADIENT_CHUNK];
+        Color4 scratch[BMR_GRADIENT_CHUNK];
+
+        bool isLinear = g.Kind != RenderCommandType::RADIAL_GRADIENT;
+
+        // NOTE(ilya.a): Vertical gradients, most common backgrounds, have 
+        // single color per row, so they are filled at fill speed.
+        if (isLinear && g.Start.X == g.End.X) {
+            for (S64 y = r.Y0; y < r.Y1; ++y) {
+                _LinearIndices(g, (F64)r.X0, (F64)y, indices, 1);
+                Raster_Fill(dst, r, Clip{r.X0, y, r.X1, y + 1}, lut[indices[0]]);
+            }
+            return;
+        }
+
+        // NOTE(ilya.a): Horizontal ones have same row everywhere, so first
+        // row is computed, and then copied.
+        S64 yEnd = isLinear && g.Start.Y == g.End.Y ? r.Y0 + 1 : r.Y1;
+
+        for (S64 y = r.Y0; y < yEnd; ++y) {
+            for (S64 x = r.X0; x < r.X1; x += BMR_GRADIENT_CHUNK) {
+                S64 count = r.X1 - x < BMR_GRADIENT_CHUNK ? r.X1 - x : BMR_GRADIENT_CHUNK;
+
+                if (g.Kind == RenderCommandType::RADIAL_GRADIENT) {
+                    _RadialIndices(g, (F64)x, (F64)y, indices, count);
+                } else {
+                    _LinearIndices(g, (F64)x, (F64)y, indices, count);
+                }
+
+                bool isDirect = dst->Format == PixelFormat::BGRA8888;
+                Color4 *out = isDirect 
+                    ? (Color4 *)GetPixelAddress(dst, x, y) 
+                    : scratch;
+
+                for (S64 i = 0; i < count; ++i) {
+                    out[i] = lut[indices[i]];
+                }
+
+                if (!isDirect) {
+                    Format_StoreSpan(dst, x, y, scratch, count);
+                }
+            }
+        }
+
+        U64 bpp = GetBytesPerPixel(dst->Format);
+        const U8 *first = GetPixelAddress(dst, r.X0, r.Y0);
+
+        for (S64 y = yEnd; y < r.Y1; ++y) {
+            memcpy(GetPixelAddress(dst, r.X0, y), first, (r.X1 - r.X0) * bpp);
+        }
+    }
+
+};  // namespace BMR
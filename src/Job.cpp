@@ -0,0 +1,170 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Job.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Job.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Thread.hpp"
+#include "Debug.hpp"
+
+
+struct _JobWorker {
+    BMR::Thread *Thread;
+    U32 Index;
+};
+
+
+GlobalVar struct {
+    U32 WorkerCount;
+    _JobWorker Workers[BMR_JOB_MAX_WORKERS];
+
+    // NOTE(ilya.a): `Start` is posted once for each worker, when loop is
+    // started, `Done` is posted by each worker, when it has nothing left.
+    BMR::Semaphore *Start;
+    BMR::Semaphore *Done;
+    bool ShouldStop;
+
+    BMR::JobProc Proc;
+    void *Data;
+    U64 Count;
+    U64 Grain;
+    volatile U64 Next;
+} Jobs;
+
+
+namespace BMR {
+
+    InternalFunc void
+    _RunParts(U32 worker) noexcept
+    {
+        for (;;) {
+            U64 begin = Atomic_FetchAdd(&Jobs.Next, Jobs.Grain);
+            if (begin >= Jobs.Count) {
+                return;
+            }
+
+            U64 end = Jobs.Count - begin < Jobs.Grain ? Jobs.Count : begin + Jobs.Grain;
+            Jobs.Proc(Jobs.Data, begin, end, worker);
+        }
+    }
+
+    InternalFunc void
+    _RunWorker(void *data) noexcept
+    {
+        auto *worker = (_JobWorker *)data;
+
+        for (;;) {
+            Semaphore_Wait(Jobs.Start);
+            if (Jobs.ShouldStop) {
+                return;
+            }
+
+            _RunParts(worker->Index);
+            Semaphore_Post(Jobs.Done, 1);
+        }
+    }
+
+    void 
+    Job_Init(U32 workerCount) noexcept
+    {
+        Jobs.WorkerCount = 0;
+        Jobs.ShouldStop = false;
+
+        workerCount = workerCount < BMR_JOB_MAX_WORKERS ? workerCount : BMR_JOB_MAX_WORKERS;
+        if (workerCount == 0) {
+            return;
+        }
+
+        Jobs.Start = Semaphore_Create();
+        Jobs.Done = Semaphore_Create();
+        if (Jobs.Start == nullptr || Jobs.Done == nullptr) {
+            Debug_Print("Failed to create semaphores, loops are run on one thread!\n");
+            Job_DeInit();
+            return;
+        }
+
+        for (U32 i = 0; i < workerCount; ++i) {
+            _JobWorker &worker = Jobs.Workers[Jobs.WorkerCount];
+            worker.Index = Jobs.WorkerCount + 1;
+            worker.Thread = Thread_Start(_RunWorker, &worker);
+
+            if (worker.Thread == nullptr) {
+                Debug_Print("Failed to start worker thread!\n");
+                break;
+            }
+
+            Jobs.WorkerCount++;
+        }
+    }
+
+    void 
+    Job_DeInit() noexcept
+    {
+        Jobs.ShouldStop = true;
+
+        if (Jobs.WorkerCount > 0) {
+            Semaphore_Post(Jobs.Start, Jobs.WorkerCount);
+        }
+
+        for (U32 i = 0; i < Jobs.WorkerCount; ++i) {
+            Thread_Join(Jobs.Workers[i].Thread);
+            Jobs.Workers[i] = _JobWorker{};
+        }
+        Jobs.WorkerCount = 0;
+
+        if (Jobs.Start != nullptr) {
+            Semaphore_Destroy(Jobs.Start);
+            Jobs.Start = nullptr;
+        }
+        if (Jobs.Done != nullptr) {
+            Semaphore_Destroy(Jobs.Done);
+            Jobs.Done = nullptr;
+        }
+    }
+
+    U32 
+    Job_GetWorkerCount() noexcept
+    {
+        return Jobs.WorkerCount;
+    }
+
+    void 
+    Job_ParallelFor(U64 count, U64 grain, JobProc proc, void *data) noexcept
+    {
+        grain = grain > 0 ? grain : 1;
+
+        if (Jobs.WorkerCount == 0 || count <= grain) {
+            if (count > 0) {
+                proc(data, 0, count, 0);
+            }
+            return;
+        }
+
+        Jobs.Proc = proc;
+        Jobs.Data = data;
+        Jobs.Count = count;
+        Jobs.Grain = grain;
+        Jobs.Next = 0;
+
+        // NOTE(ilya.a): Only as many workers are woken up, as there are
+        // parts left for them.
+        U64 parts = (count + grain - 1) / grain;
+        U32 woken = parts - 1 < Jobs.WorkerCount ? (U32)(parts - 1) : Jobs.WorkerCount;
+
+        Semaphore_Post(Jobs.Start, woken);
+        _RunParts(0);
+
+        for (U32 i = 0; i < woken; ++i) {
+            Semaphore_Wait(Jobs.Done);
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,50 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Job.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Pool of worker threads, which are splitting loops between each other.
+ * Workers are sleeping, while there's nothing to do.
+ * */
+
+#ifndef SBMR_JOB_HPP_INCLUDED
+#define SBMR_JOB_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+#define BMR_JOB_MAX_WORKERS 15
+
+
+namespace BMR {
+
+    /*
+     * Processes `[begin; end)` part of the loop. `worker` is in range 
+     * `[0; Job_GetWorkerCount()]`, zero is the thread, which started the
+     * loop, so it can be used to pick scratch memory.
+     */
+    typedef void (*JobProc)(void *data, U64 begin, U64 end, U32 worker) noexcept;
+
+    /*
+     * Starts `workerCount` threads in addition to the calling one. With
+     * zero workers every loop is run on calling thread.
+     */
+    void Job_Init(U32 workerCount) noexcept;
+    void Job_DeInit() noexcept;
+
+    U32 Job_GetWorkerCount() noexcept;
+
+    /*
+     * Runs `proc` over `[0; count)` in parts of `grain` iterations, and
+     * returns, when all of them are done. Must not be called from `proc`.
+     */
+    void Job_ParallelFor(U64 count, U64 grain, JobProc proc, void *data) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_JOB_HPP_INCLUDED
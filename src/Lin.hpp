@@ -13,6 +13,8 @@
 #define SBMR_LIN_HPP_INCLUDED
 
 
+#include <math.h>
+
 #include "Types.hpp"
 
 
@@ -36,4 +38,93 @@ struct Vec2u {
     { }
 };
 
+
+#define BMR_FIXED_SHIFT 16
+#define BMR_FIXED_ONE   (1 << BMR_FIXED_SHIFT)
+
+
+constexpr S64
+ToFixed(F64 value) noexcept
+{
+    return (S64)(value * BMR_FIXED_ONE + (value < 0 ? -0.5 : 0.5));
+}
+
+
+/*
+ * 2x3 affine transform in 16.16 fixed point, so composition gives the
+ * same result everywhere. Point is mapped as
+ *
+ *   x' = A * x + B * y + X
+ *   y' = C * x + D * y + Y
+ */
+struct Transform {
+    S32 A;
+    S32 B;
+    S32 C;
+    S32 D;
+    S64 X;
+    S64 Y;
+
+    constexpr Transform(S32 a = BMR_FIXED_ONE, S32 b = 0, 
+                        S32 c = 0, S32 d = BMR_FIXED_ONE, 
+                        S64 x = 0, S64 y = 0) noexcept 
+        : A(a), B(b), C(c), D(d), X(x), Y(y)
+    { }
+
+    static constexpr Transform 
+    Translation(F64 x, F64 y) noexcept
+    {
+        return Transform(BMR_FIXED_ONE, 0, 0, BMR_FIXED_ONE, ToFixed(x), ToFixed(y));
+    }
+
+    static constexpr Transform 
+    Scaling(F64 x, F64 y) noexcept
+    {
+        return Transform((S32)ToFixed(x), 0, 0, (S32)ToFixed(y));
+    }
+
+    // NOTE(ilya.a): Y axis points down, so positive angle is clockwise
+    // on screen.
+    static Transform 
+    Rotation(F64 radians) noexcept
+    {
+        S32 c = (S32)ToFixed(cos(radians));
+        S32 s = (S32)ToFixed(sin(radians));
+        return Transform(c, -s, s, c);
+    }
+
+    /*
+     * Transform, which applies `t` first, then this one.
+     */
+    constexpr Transform 
+    operator*(const Transform &t) const noexcept
+    {
+        constexpr S64 half = BMR_FIXED_ONE / 2;
+
+        return Transform(
+            (S32)(((S64)A * t.A + (S64)B * t.C + half) >> BMR_FIXED_SHIFT),
+            (S32)(((S64)A * t.B + (S64)B * t.D + half) >> BMR_FIXED_SHIFT),
+            (S32)(((S64)C * t.A + (S64)D * t.C + half) >> BMR_FIXED_SHIFT),
+            (S32)(((S64)C * t.B + (S64)D * t.D + half) >> BMR_FIXED_SHIFT),
+            (((S64)A * t.X + (S64)B * t.Y + half) >> BMR_FIXED_SHIFT) + X,
+            (((S64)C * t.X + (S64)D * t.Y + half) >> BMR_FIXED_SHIFT) + Y);
+    }
+
+    constexpr bool 
+    IsIdentity() const noexcept
+    {
+        return A == BMR_FIXED_ONE && B == 0 && C == 0 && D == BMR_FIXED_ONE && X == 0 && Y == 0;
+    }
+
+    /*
+     * Edges of rect stay parallel to axes: it's scaled, flipped or rotated
+     * by multiple of 90 degrees.
+     */
+    constexpr bool 
+    IsAxisAligned() const noexcept
+    {
+        return (B == 0 && C == 0) || (A == 0 && D == 0);
+    }
+};
+
 #endif // SBMR_LIN_HPP_INCLUDED
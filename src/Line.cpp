@@ -0,0 +1,172 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Line.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Raster.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Format.hpp"
+#include "Gamma.hpp"
+
+
+namespace BMR {
+
+    InternalFunc inline void
+    _Plot(Surface *dst, S64 x, S64 y, U32 value) noexcept
+    {
+        U8 *pixel = GetPixelAddress(dst, x, y);
+
+        switch (dst->Format) {
+            case (PixelFormat::RGB565):   *((U16 *)pixel) = (U16)value; break;
+            case (PixelFormat::INDEXED8): *pixel = (U8)value;           break;
+            case (PixelFormat::BGRA8888):
+            default:                      *((U32 *)pixel) = value;      break;
+        }
+    }
+
+    InternalFunc inline void
+    _PlotBlend(Surface *dst, S64 x, S64 y, 
+               const LinearColor &c, U8 coverage) noexcept
+    {
+        if (dst->Format == PixelFormat::BGRA8888) {
+            Color4 *pixel = (Color4 *)GetPixelAddress(dst, x, y);
+            *pixel = Gamma_Blend(*pixel, c, coverage);
+            return;
+        }
+
+        Color4 pixel;
+        Format_LoadSpan(dst, x, y, &pixel, 1);
+        pixel = Gamma_Blend(pixel, c, coverage);
+        Format_StoreSpan(dst, x, y, &pixel, 1);
+    }
+
+    /*
+     * Walks line along its major axis. Only steps, which are inside of the
+     * clip along major axis, are visited, so offscreen part of long line 
+     * costs nothing.
+     *
+     * Minor coordinate at step `k` is `k * minorDelta / majorDelta`, which
+     * is tracked exactly as quotient and remainder.
+     */
+    void 
+    Raster_Line(Surface *dst, const Clip &clip, 
+                Vec2u p1, Vec2u p2, 
+                const Color4 &c, LineMode mode) noexcept
+    {
+        Clip r = clip.Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        S64 dx = (S64)p2.X - (S64)p1.X;
+        S64 dy = (S64)p2.Y - (S64)p1.Y;
+        bool isSteep = (dx < 0 ? -dx : dx) < (dy < 0 ? -dy : dy);
+
+        // NOTE(ilya.a): Swap axes, so X is always major one.
+        S64 x0 = p1.X, y0 = p1.Y, x1 = p2.X, y1 = p2.Y;
+        S64 minX = r.X0, maxX = r.X1, minY = r.Y0, maxY = r.Y1;
+        if (isSteep) {
+            S64 t;
+            t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+            minX = r.Y0; maxX = r.Y1; minY = r.X0; maxY = r.X1;
+        }
+        if (x0 > x1) {
+            S64 t;
+            t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        U64 majorDelta = (U64)(x1 - x0);
+        U64 minorDelta = (U64)(y1 > y0 ? y1 - y0 : y0 - y1);
+        S64 minorStep  = y1 >= y0 ? 1 : -1;
+
+        S64 xBegin = x0 > minX ? x0 : minX;
+        S64 xEnd   = x1 + 1 < maxX ? x1 + 1 : maxX;
+        if (xBegin >= xEnd) {
+            return;
+        }
+
+        U64 k = (U64)(xBegin - x0);
+        U32 value = Format_Pack(dst, c);
+
+        if (mode == LineMode::ANTIALIASED && majorDelta != 0) {
+            LinearColor lc = Gamma_ToLinearColor(c);
+            U64 q = (k * minorDelta) / majorDelta;
+            U64 rem = (k * minorDelta) % majorDelta;
+
+            // NOTE(ilya.a): Coverage is `255 * rem / majorDelta`, which is
+            // also tracked as quotient and remainder. Multiplying by
+            // reciprocal is off by one, when fraction is close to integer.
+            U64 coverageStep = (U64)MAX_U8 * minorDelta;
+            U64 coverageStepQ = coverageStep / majorDelta;
+            U64 coverageStepR = coverageStep % majorDelta;
+            U64 coverageQ = ((U64)MAX_U8 * rem) / majorDelta;
+            U64 coverageR = ((U64)MAX_U8 * rem) % majorDelta;
+
+            for (S64 x = xBegin; x < xEnd; ++x) {
+                U8 coverage = (U8)coverageQ;
+                S64 y = y0 + minorStep * (S64)q;
+
+                if (y >= minY && y < maxY) {
+                    isSteep 
+                        ? _PlotBlend(dst, y, x, lc, MAX_U8 - coverage) 
+                        : _PlotBlend(dst, x, y, lc, MAX_U8 - coverage);
+                }
+                y += minorStep;
+                if (coverage != 0 && y >= minY && y < maxY) {
+                    isSteep 
+                        ? _PlotBlend(dst, y, x, lc, coverage) 
+                        : _PlotBlend(dst, x, y, lc, coverage);
+                }
+
+                coverageQ += coverageStepQ;
+                coverageR += coverageStepR;
+                if (coverageR >= majorDelta) {
+                    coverageR -= majorDelta;
+                    ++coverageQ;
+                }
+
+                rem += minorDelta;
+                if (rem >= majorDelta) {
+                    rem -= majorDelta;
+                    coverageQ -= MAX_U8;
+                    ++q;
+                }
+            }
+            return;
+        }
+
+        // NOTE(ilya.a): Bresenham, minor coordinate is rounded to nearest.
+        // [https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm]
+        U64 major = majorDelta == 0 ? 1 : majorDelta;
+        U64 denom = 2 * major;
+        U64 num = 2 * ((k * minorDelta) % major) + majorDelta;
+        U64 q = (k * minorDelta) / major + num / denom;
+        U64 rem = num % denom;
+
+        for (S64 x = xBegin; x < xEnd; ++x) {
+            S64 y = y0 + minorStep * (S64)q;
+
+            if (y >= minY && y < maxY) {
+                isSteep ? _Plot(dst, y, x, value) : _Plot(dst, x, y, value);
+            }
+
+            rem += 2 * minorDelta;
+            if (rem >= denom) {
+                rem -= denom;
+                ++q;
+            }
+        }
+    }
+
+};  // namespace BMR
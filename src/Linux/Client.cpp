@@ -0,0 +1,212 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Client.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "Linux/Client.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+
+
+namespace BMR {
+
+    InternalFunc bool
+    _SendMessage(Client *client, const ServerMessage &message, 
+                 const void *tail = nullptr, Size tailSize = 0) noexcept
+    {
+        iovec iov[2] = {};
+        iov[0].iov_base = (void *)&message;
+        iov[0].iov_len = sizeof(message);
+        iov[1].iov_base = (void *)tail;
+        iov[1].iov_len = tailSize;
+
+        msghdr header = {};
+        header.msg_iov = iov;
+        header.msg_iovlen = tailSize > 0 ? 2 : 1;
+
+        return sendmsg(client->Socket, &header, MSG_NOSIGNAL) 
+            == (ssize_t)(sizeof(message) + tailSize);
+    }
+
+    InternalFunc bool
+    _ReceiveMessage(Client *client, Out ServerMessage *message, 
+                    Out int *fd = nullptr) noexcept
+    {
+        iovec iov = {};
+        iov.iov_base = message;
+        iov.iov_len = sizeof(*message);
+
+        msghdr header = {};
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+
+        if (recvmsg(client->Socket, &header, MSG_CMSG_CLOEXEC) != (ssize_t)sizeof(*message)) {
+            return false;
+        }
+
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                int received = -1;
+                memcpy(&received, CMSG_DATA(cmsg), sizeof(int));
+
+                if (fd != nullptr) {
+                    *fd = received;
+                } else {
+                    close(received);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool 
+    Client_Connect(Client *client, CStr path, 
+                   U32 w, U32 h, PixelFormat format, 
+                   U32 slotCount) noexcept
+    {
+        *client = Client{};
+        client->Memory = -1;
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            return false;
+        }
+        strcpy(address.sun_path, path);
+
+        client->Socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (client->Socket < 0) {
+            return false;
+        }
+
+        if (connect(client->Socket, (const sockaddr *)&address, sizeof(address)) != 0) {
+            Client_Disconnect(client);
+            return false;
+        }
+
+        ServerMessage hello = {};
+        hello.Type = ServerMessageType::HELLO;
+        hello.Hello.Width = w;
+        hello.Hello.Height = h;
+        hello.Hello.Format = format;
+        hello.Hello.SlotCount = slotCount;
+
+        ServerMessage reply = {};
+        if (!_SendMessage(client, hello) 
+            || !_ReceiveMessage(client, &reply, &client->Memory)
+            || reply.Type != ServerMessageType::RING
+            || client->Memory < 0) {
+            Client_Disconnect(client);
+            return false;
+        }
+
+        client->Layout = reply.Ring;
+
+        void *ring = mmap(
+            nullptr, client->Layout.Size, PROT_READ, MAP_SHARED, client->Memory, 0);
+        if (ring == MAP_FAILED) {
+            Client_Disconnect(client);
+            return false;
+        }
+        client->Ring = (const U8 *)ring;
+
+        return true;
+    }
+
+    void 
+    Client_Disconnect(Client *client) noexcept
+    {
+        if (client->Ring != nullptr) {
+            munmap((void *)client->Ring, client->Layout.Size);
+        }
+
+        if (client->Memory >= 0) {
+            close(client->Memory);
+        }
+
+        if (client->Socket >= 0) {
+            close(client->Socket);
+        }
+
+        *client = Client{};
+        client->Socket = -1;
+        client->Memory = -1;
+    }
+
+    bool 
+    Client_Submit(Client *client) noexcept
+    {
+        const void *commands = nullptr;
+        Size size = 0;
+        U64 count = 0;
+        GetCommands(&commands, &size, &count);
+
+        ServerMessage message = {};
+        message.Type = ServerMessageType::SUBMIT;
+        message.Submit.CommandCount = count;
+        message.Submit.Size = size;
+
+        bool sent = _SendMessage(client, message, commands, size);
+        DiscardCommands();
+
+        return sent;
+    }
+
+    bool 
+    Client_WaitFrame(Client *client, 
+                     Out Surface *frame, Out ServerFrame *info) noexcept
+    {
+        ServerMessage reply = {};
+
+        if (!_ReceiveMessage(client, &reply) || reply.Type != ServerMessageType::FRAME) {
+            return false;
+        }
+
+        *info = reply.Frame;
+
+        if (info->Status != FrameStatus::READY || info->Slot >= client->Layout.SlotCount) {
+            return false;
+        }
+
+        frame->Buffer = (void *)(client->Ring + info->Slot * client->Layout.SlotSize);
+        frame->Width = client->Layout.Width;
+        frame->Height = client->Layout.Height;
+        frame->Pitch = client->Layout.Pitch;
+        frame->Format = client->Layout.Format;
+        frame->Palette = nullptr;
+
+        return true;
+    }
+
+    bool 
+    Client_ReleaseFrame(Client *client, U32 slot) noexcept
+    {
+        ServerMessage message = {};
+        message.Type = ServerMessageType::RELEASE;
+        message.Release.Slot = slot;
+
+        return _SendMessage(client, message);
+    }
+
+};  // namespace BMR
@@ -0,0 +1,54 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Client.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Client of render server (`Linux/Server.hpp`). Commands are built with
+ * regular `BMR::Draw*` calls and shipped with `Client_Submit` instead of
+ * `BMR::EndDrawing`.
+ * */
+
+#ifndef SBMR_LINUX_CLIENT_HPP_INCLUDED
+#define SBMR_LINUX_CLIENT_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "Linux/Server.hpp"
+
+
+namespace BMR {
+
+    struct Client {
+        int Socket;
+        int Memory;
+        const U8 *Ring;
+        ServerRing Layout;
+    };
+
+    bool Client_Connect(Client *client, CStr path, 
+                        U32 w, U32 h, PixelFormat format, 
+                        U32 slotCount = 2) noexcept;
+    void Client_Disconnect(Client *client) noexcept;
+
+    /*
+     * Sends commands, which were pushed since last submit, and clears
+     * the queue.
+     */
+    bool Client_Submit(Client *client) noexcept;
+
+    /*
+     * Waits for result of the oldest submit. `frame` points into shared
+     * memory and stays valid until slot is released.
+     */
+    bool Client_WaitFrame(Client *client, 
+                          Out Surface *frame, Out ServerFrame *info) noexcept;
+    bool Client_ReleaseFrame(Client *client, U32 slot) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_LINUX_CLIENT_HPP_INCLUDED
@@ -0,0 +1,137 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Memory.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Memory.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+#define BMR_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+
+namespace BMR {
+
+    void *
+    Memory_Reserve(Size size, bool preferHugePages, 
+                   Out Size *granularity) noexcept
+    {
+        *granularity = (Size)sysconf(_SC_PAGESIZE);
+
+        // NOTE(ilya.a): Explicit huge pages (`MAP_HUGETLB`) are not used,
+        // since whole mapping would be charged against the pool right away.
+        // Transparent huge pages need only aligned base, so address space
+        // is reserved with slack, which is cut off.
+        bool isAligned = preferHugePages && size >= BMR_HUGE_PAGE_SIZE;
+        Size slack = isAligned ? BMR_HUGE_PAGE_SIZE : 0;
+
+        U8 *p = (U8 *)mmap(
+            nullptr, size + slack, PROT_NONE, 
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+        if (p == MAP_FAILED) {
+            return nullptr;
+        }
+
+        if (isAligned) {
+            U8 *base = (U8 *)AlignUp((Size)p, BMR_HUGE_PAGE_SIZE);
+            Size tail = (Size)(p + size + slack - (base + AlignUp(size, *granularity)));
+
+            if (base > p) {
+                munmap(p, (Size)(base - p));
+            }
+            if (tail > 0) {
+                munmap(base + AlignUp(size, *granularity), tail);
+            }
+            p = base;
+        }
+
+        return p;
+    }
+
+    bool 
+    Memory_Commit(void *p, Size size, bool preferHugePages) noexcept
+    {
+        if (mprotect(p, size, PROT_READ | PROT_WRITE) != 0) {
+            return false;
+        }
+
+        if (preferHugePages) {
+            // NOTE(ilya.a): Only a hint for committed range, so error is
+            // ignored.
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+
+        return true;
+    }
+
+    bool 
+    Memory_Decommit(void *p, Size size) noexcept
+    {
+        if (madvise(p, size, MADV_DONTNEED) != 0) {
+            return false;
+        }
+
+        return mprotect(p, size, PROT_NONE) == 0;
+    }
+
+    void 
+    Memory_Release(void *p, Size size) noexcept
+    {
+        munmap(p, size);
+    }
+
+    void *
+    Memory_MapFile(CStr path, Out Size *size) noexcept
+    {
+        *size = 0;
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        struct stat info;
+        void *p = MAP_FAILED;
+
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            // NOTE(ilya.a): File is read right away, so pages are faulted
+            // in by single call instead of one by one. Read only, so they
+            // are shared with page cache instead of being copied.
+            p = mmap(
+                nullptr, (Size)info.st_size, PROT_READ, 
+                MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        }
+
+        // NOTE(ilya.a): Mapping keeps its own reference to the file.
+        close(fd);
+
+        if (p == MAP_FAILED) {
+            return nullptr;
+        }
+
+        *size = (Size)info.st_size;
+        return p;
+    }
+
+    void 
+    Memory_UnmapFile(void *p, Size size) noexcept
+    {
+        if (p != nullptr) {
+            munmap(p, size);
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,378 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Server.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "Linux/Server.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "Memory.hpp"
+#include "Debug.hpp"
+#include "Command.hpp"
+#include "BMR.hpp"
+
+
+// NOTE(ilya.a): Upper bound of time it takes to notice `Server_Stop`, which
+// was called from other thread.
+#define BMR_SERVER_POLL_TIMEOUT_MS 100
+
+
+namespace BMR {
+
+    struct _Client {
+        int Socket;
+        int Memory;     // NOTE(ilya.a): `-1` until HELLO.
+        U8 *Ring;
+        ServerRing Layout;
+
+        bool Busy[BMR_SERVER_MAX_SLOTS];
+        U32 NextSlot;
+        U64 Sequence;
+    };
+
+};  // namespace BMR
+
+
+GlobalVar struct {
+    volatile sig_atomic_t ShouldStop;
+
+    BMR::_Client Clients[BMR_SERVER_MAX_CLIENTS];
+    U32 ClientCount;
+
+    // NOTE(ilya.a): Commands are copied into the queue before they are
+    // read, but they are kept aligned here too.
+    alignas(BMR_CACHE_LINE_SIZE) U8 Buffer[BMR_SERVER_MESSAGE_MAX_SIZE];
+} Server;
+
+static_assert(sizeof(BMR::ServerMessage) % BMR_COMMAND_ALIGNMENT == 0);
+
+
+namespace BMR {
+
+    /*
+     * Sends message, passing `fd` along with it, if it's not `-1`. Returns
+     * `false`, if client should be disconnected.
+     */
+    InternalFunc bool
+    _Send(int socket, const ServerMessage &message, int fd = -1) noexcept
+    {
+        iovec iov = {};
+        iov.iov_base = (void *)&message;
+        iov.iov_len = sizeof(message);
+
+        msghdr header = {};
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+        if (fd >= 0) {
+            header.msg_control = control;
+            header.msg_controllen = sizeof(control);
+
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        }
+
+        // NOTE(ilya.a): Server is single threaded, so client, which doesn't
+        // read its replies, must not block it. Full socket buffer fails the
+        // send, and client is disconnected.
+        return sendmsg(socket, &header, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)sizeof(message);
+    }
+
+    InternalFunc void
+    _CloseClient(U32 clientIdx) noexcept
+    {
+        _Client &client = Server.Clients[clientIdx];
+
+        if (client.Ring != nullptr) {
+            munmap(client.Ring, client.Layout.Size);
+        }
+
+        if (client.Memory >= 0) {
+            close(client.Memory);
+        }
+
+        close(client.Socket);
+
+        Server.ClientCount--;
+        Server.Clients[clientIdx] = Server.Clients[Server.ClientCount];
+    }
+
+    InternalFunc bool
+    _HandleHello(_Client &client, const ServerHello &hello) noexcept
+    {
+        if (client.Memory >= 0) {
+            return false;
+        }
+
+        if (hello.Width == 0 || hello.Width > BMR_FRAMEBUFFER_MAX_WIDTH
+            || hello.Height == 0 || hello.Height > BMR_FRAMEBUFFER_MAX_HEIGHT
+            || hello.Format == PixelFormat::INDEXED8
+            || hello.SlotCount == 0 || hello.SlotCount > BMR_SERVER_MAX_SLOTS) {
+            Debug_Print("Client asked for unsupported frame!\n");
+            return false;
+        }
+
+        ServerRing &layout = client.Layout;
+        layout.Width = hello.Width;
+        layout.Height = hello.Height;
+        layout.Format = hello.Format;
+        layout.SlotCount = hello.SlotCount;
+        layout.Pitch = AlignUp(
+            (Size)hello.Width * GetBytesPerPixel(hello.Format), BMR_CACHE_LINE_SIZE);
+        layout.SlotSize = AlignUp(layout.Pitch * hello.Height, (Size)sysconf(_SC_PAGESIZE));
+        layout.Size = layout.SlotSize * hello.SlotCount;
+
+        client.Memory = memfd_create("sbmr-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (client.Memory < 0) {
+            Debug_Print("Failed to create shared memory for client!\n");
+            return false;
+        }
+
+        // NOTE(ilya.a): Sealed, so client can't shrink the file under our
+        // mapping and make us crash on SIGBUS.
+        if (ftruncate(client.Memory, (off_t)layout.Size) != 0
+            || fcntl(client.Memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+            Debug_Print("Failed to allocate shared memory for client!\n");
+            return false;
+        }
+
+        void *ring = mmap(
+            nullptr, layout.Size, PROT_READ | PROT_WRITE, MAP_SHARED, client.Memory, 0);
+        if (ring == MAP_FAILED) {
+            Debug_Print("Failed to map shared memory of client!\n");
+            return false;
+        }
+        client.Ring = (U8 *)ring;
+
+        ServerMessage reply = {};
+        reply.Type = ServerMessageType::RING;
+        reply.Ring = layout;
+
+        return _Send(client.Socket, reply, client.Memory);
+    }
+
+    InternalFunc bool
+    _HandleSubmit(_Client &client, const ServerSubmit &submit,
+                  const U8 *commands, Size size) noexcept
+    {
+        if (client.Ring == nullptr) {
+            return false;
+        }
+
+        ServerMessage reply = {};
+        reply.Type = ServerMessageType::FRAME;
+        reply.Frame.Slot = client.Layout.SlotCount;
+        reply.Frame.Sequence = client.Sequence;
+
+        U32 slot = client.Layout.SlotCount;
+        for (U32 i = 0; i < client.Layout.SlotCount; ++i) {
+            U32 candidate = (client.NextSlot + i) % client.Layout.SlotCount;
+
+            if (!client.Busy[candidate]) {
+                slot = candidate;
+                break;
+            }
+        }
+
+        if (slot == client.Layout.SlotCount) {
+            reply.Frame.Status = FrameStatus::DROPPED;
+        } else if (submit.Size != size || !SubmitCommands(commands, size, submit.CommandCount)) {
+            reply.Frame.Status = FrameStatus::REJECTED;
+        } else {
+            Surface frame = {};
+            frame.Buffer = client.Ring + slot * client.Layout.SlotSize;
+            frame.Width = client.Layout.Width;
+            frame.Height = client.Layout.Height;
+            frame.Pitch = client.Layout.Pitch;
+            frame.Format = client.Layout.Format;
+
+            BeginDrawing(&frame);
+            EndDrawing();
+
+            // NOTE(ilya.a): `frame` is gone after return, so instance must
+            // not be left pointing at it.
+            BeginDrawing(GetBackbuffer());
+
+            client.Busy[slot] = true;
+            client.NextSlot = (slot + 1) % client.Layout.SlotCount;
+            client.Sequence++;
+
+            reply.Frame.Slot = slot;
+            reply.Frame.Status = FrameStatus::READY;
+            reply.Frame.Sequence = client.Sequence;
+        }
+
+        return _Send(client.Socket, reply);
+    }
+
+    /*
+     * Returns `false`, if client should be disconnected.
+     */
+    InternalFunc bool
+    _Receive(_Client &client) noexcept
+    {
+        ssize_t received = recv(
+            client.Socket, Server.Buffer, sizeof(Server.Buffer), MSG_TRUNC);
+
+        // NOTE(ilya.a): `MSG_TRUNC` makes `recv` return real size of packet,
+        // so oversized packets are detected instead of being cut silently.
+        if (received < (ssize_t)sizeof(ServerMessage)
+            || received > (ssize_t)sizeof(Server.Buffer)) {
+            return false;
+        }
+
+        const ServerMessage *message = (const ServerMessage *)Server.Buffer;
+
+        switch (message->Type) {
+            case (ServerMessageType::HELLO): {
+                return _HandleHello(client, message->Hello);
+            } break;
+            case (ServerMessageType::SUBMIT): {
+                return _HandleSubmit(
+                    client, message->Submit,
+                    Server.Buffer + sizeof(ServerMessage),
+                    (Size)received - sizeof(ServerMessage));
+            } break;
+            case (ServerMessageType::RELEASE): {
+                if (message->Release.Slot < client.Layout.SlotCount) {
+                    client.Busy[message->Release.Slot] = false;
+                }
+                return true;
+            } break;
+            default: {
+                return false;
+            } break;
+        }
+    }
+
+    InternalFunc void
+    _Accept(int listener) noexcept
+    {
+        int socket = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (socket < 0) {
+            return;
+        }
+
+        if (Server.ClientCount == BMR_SERVER_MAX_CLIENTS) {
+            Debug_Print("Too many clients, connection is refused!\n");
+            close(socket);
+            return;
+        }
+
+        _Client &client = Server.Clients[Server.ClientCount++];
+        client = _Client{};
+        client.Socket = socket;
+        client.Memory = -1;
+    }
+
+    bool
+    Server_Run(CStr path) noexcept
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            Debug_Print("Path of server socket is too long!\n");
+            return false;
+        }
+        strcpy(address.sun_path, path);
+
+        int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (listener < 0) {
+            Debug_Print("Failed to create server socket!\n");
+            return false;
+        }
+
+        unlink(path);
+
+        if (bind(listener, (const sockaddr *)&address, sizeof(address)) != 0
+            || listen(listener, BMR_SERVER_MAX_CLIENTS) != 0) {
+            Debug_Print("Failed to listen on server socket!\n");
+            close(listener);
+            return false;
+        }
+
+        Server.ShouldStop = 0;
+        Server.ClientCount = 0;
+
+        pollfd fds[BMR_SERVER_MAX_CLIENTS + 1];
+
+        while (!Server.ShouldStop) {
+            fds[0].fd = listener;
+            fds[0].events = POLLIN;
+            fds[0].revents = 0;
+
+            for (U32 i = 0; i < Server.ClientCount; ++i) {
+                fds[i + 1].fd = Server.Clients[i].Socket;
+                fds[i + 1].events = POLLIN;
+                fds[i + 1].revents = 0;
+            }
+
+            int ready = poll(fds, Server.ClientCount + 1, BMR_SERVER_POLL_TIMEOUT_MS);
+            if (ready < 0 && errno != EINTR) {
+                Debug_Print("Failed to poll server sockets!\n");
+                break;
+            }
+
+            if (ready <= 0) {
+                continue;
+            }
+
+            // NOTE(ilya.a): Backwards, because closed client is replaced by
+            // the last one, which is already handled.
+            for (U32 i = Server.ClientCount; i > 0; --i) {
+                short events = fds[i].revents;
+
+                if (events == 0) {
+                    continue;
+                }
+
+                if (!(events & POLLIN) || !_Receive(Server.Clients[i - 1])) {
+                    _CloseClient(i - 1);
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                _Accept(listener);
+            }
+        }
+
+        while (Server.ClientCount > 0) {
+            _CloseClient(Server.ClientCount - 1);
+        }
+
+        close(listener);
+        unlink(path);
+
+        return true;
+    }
+
+    void
+    Server_Stop() noexcept
+    {
+        Server.ShouldStop = 1;
+    }
+
+};  // namespace BMR
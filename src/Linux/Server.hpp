@@ -0,0 +1,115 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Server.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Render server. Local processes connect over Unix domain socket, submit
+ * serialized command queues and get finished frames back in shared memory.
+ *
+ * Protocol (`SOCK_SEQPACKET`, one message per packet):
+ *
+ *   client -> HELLO                  server -> RING + memfd (SCM_RIGHTS)
+ *   client -> SUBMIT + commands      server -> FRAME
+ *   client -> RELEASE
+ *
+ * Memfd holds `SlotCount` frames of client's size and format, `SlotSize`
+ * bytes apart. Frame is rendered into free slot, which then belongs to
+ * client until it's released, so pixels are never copied through socket.
+ * Slot is not cleared, when it's reused, so every batch should start with
+ * `CLEAR` or cover whole frame.
+ * */
+
+#ifndef SBMR_LINUX_SERVER_HPP_INCLUDED
+#define SBMR_LINUX_SERVER_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+
+
+#define BMR_SERVER_MAX_CLIENTS 32
+#define BMR_SERVER_MAX_SLOTS   4
+#define BMR_SERVER_DEFAULT_PATH "/tmp/sbmr.sock"
+
+
+namespace BMR {
+
+    enum class ServerMessageType : U32 {
+        HELLO   = 1,
+        RING    = 2,
+        SUBMIT  = 3,
+        FRAME   = 4,
+        RELEASE = 5,
+    };
+
+    enum class FrameStatus : U32 {
+        READY    = 0,
+        DROPPED  = 1,  // NOTE(ilya.a): All slots are held by client.
+        REJECTED = 2,  // NOTE(ilya.a): Commands are malformed.
+    };
+
+    struct ServerHello {
+        U32         Width;
+        U32         Height;
+        PixelFormat Format;     // NOTE(ilya.a): `INDEXED8` is not supported.
+        U32         SlotCount;  // NOTE(ilya.a): At most `BMR_SERVER_MAX_SLOTS`.
+    };
+
+    struct ServerRing {
+        U64         Size;
+        U64         SlotSize;
+        U64         Pitch;
+        U32         Width;
+        U32         Height;
+        PixelFormat Format;
+        U32         SlotCount;
+    };
+
+    struct ServerSubmit {
+        U64 CommandCount;
+        U64 Size;          // NOTE(ilya.a): Commands follow the message.
+    };
+
+    struct ServerFrame {
+        U32         Slot;
+        FrameStatus Status;
+        U64         Sequence;
+    };
+
+    struct ServerRelease {
+        U32 Slot;
+    };
+
+    struct ServerMessage {
+        ServerMessageType Type;
+
+        union {
+            ServerHello   Hello;
+            ServerRing    Ring;
+            ServerSubmit  Submit;
+            ServerFrame   Frame;
+            ServerRelease Release;
+        };
+    };
+
+    #define BMR_SERVER_MESSAGE_MAX_SIZE (sizeof(BMR::ServerMessage) + BMR_RENDER_COMMAND_CAPACITY)
+
+
+    /*
+     * Listens on `path` and serves clients until `Server_Stop` is called.
+     * Renderer must be initialized with `BMR::Init`.
+     */
+    bool Server_Run(CStr path) noexcept;
+
+    /*
+     * Can be called from signal handler.
+     */
+    void Server_Stop() noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_LINUX_SERVER_HPP_INCLUDED
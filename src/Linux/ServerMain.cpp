@@ -0,0 +1,45 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/ServerMain.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Usage: sbmr-server [socket-path]
+ * */
+
+#include <signal.h>
+
+#include "Types.hpp"
+#include "BMR.hpp"
+#include "Linux/Server.hpp"
+
+
+static void
+Linux_HandleStop(int signal)
+{
+    (void)signal;
+    BMR::Server_Stop();
+}
+
+
+int
+main(int argc, char **argv)
+{
+    CStr path = argc > 1 ? argv[1] : BMR_SERVER_DEFAULT_PATH;
+
+    // NOTE(ilya.a): Without `SA_RESTART`, so `poll` is interrupted.
+    struct sigaction action = {};
+    action.sa_handler = Linux_HandleStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    BMR::Init();
+    bool ok = BMR::Server_Run(path);
+    BMR::DeInit();
+
+    return ok ? 0 : 1;
+}
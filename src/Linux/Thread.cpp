@@ -0,0 +1,119 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Thread.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#include "Thread.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Memory.hpp"
+
+
+namespace BMR {
+
+    struct Thread {
+        pthread_t  Handle;
+        ThreadProc Proc;
+        void      *Data;
+    };
+
+    struct Semaphore {
+        sem_t Handle;
+    };
+
+    InternalFunc void *
+    _RunThread(void *data) noexcept
+    {
+        auto *thread = (Thread *)data;
+        thread->Proc(thread->Data);
+        return nullptr;
+    }
+
+    Thread *
+    Thread_Start(ThreadProc proc, void *data) noexcept
+    {
+        auto *thread = (Thread *)Memory_Allocate(sizeof(Thread));
+        if (thread == nullptr) {
+            return nullptr;
+        }
+
+        thread->Proc = proc;
+        thread->Data = data;
+
+        if (pthread_create(&thread->Handle, nullptr, _RunThread, thread) != 0) {
+            Memory_Free(thread, sizeof(Thread));
+            return nullptr;
+        }
+
+        return thread;
+    }
+
+    void 
+    Thread_Join(Thread *thread) noexcept
+    {
+        pthread_join(thread->Handle, nullptr);
+        Memory_Free(thread, sizeof(Thread));
+    }
+
+    U32 
+    Thread_GetProcessorCount() noexcept
+    {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            return (U32)CPU_COUNT(&set);
+        }
+
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (U32)count : 1;
+    }
+
+    Semaphore *
+    Semaphore_Create() noexcept
+    {
+        auto *semaphore = (Semaphore *)Memory_Allocate(sizeof(Semaphore));
+        if (semaphore == nullptr) {
+            return nullptr;
+        }
+
+        if (sem_init(&semaphore->Handle, 0, 0) != 0) {
+            Memory_Free(semaphore, sizeof(Semaphore));
+            return nullptr;
+        }
+
+        return semaphore;
+    }
+
+    void 
+    Semaphore_Destroy(Semaphore *semaphore) noexcept
+    {
+        sem_destroy(&semaphore->Handle);
+        Memory_Free(semaphore, sizeof(Semaphore));
+    }
+
+    void 
+    Semaphore_Wait(Semaphore *semaphore) noexcept
+    {
+        while (sem_wait(&semaphore->Handle) != 0 && errno == EINTR) {
+        }
+    }
+
+    void 
+    Semaphore_Post(Semaphore *semaphore, U32 count) noexcept
+    {
+        for (U32 i = 0; i < count; ++i) {
+            sem_post(&semaphore->Handle);
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,42 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Linux/Time.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <errno.h>
+#include <time.h>
+
+#include "Time.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+namespace BMR {
+
+    U64
+    Time_Now() noexcept
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (U64)now.tv_sec * BMR_NS_PER_SECOND + (U64)now.tv_nsec;
+    }
+
+    void
+    Time_Sleep(U64 ns) noexcept
+    {
+        timespec duration;
+        duration.tv_sec = (time_t)(ns / BMR_NS_PER_SECOND);
+        duration.tv_nsec = (long)(ns % BMR_NS_PER_SECOND);
+
+        // NOTE(ilya.a): Signal interrupts sleep, rest of it is slept again.
+        while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+        }
+    }
+
+};  // namespace BMR
@@ -12,7 +12,19 @@
  * graphics.
  * */
 
-#include <Windows.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+    #include <Windows.h>
+#else
+    #include <stdlib.h>
+    #include <string.h>
+
+    #include <X11/Xlib.h>
+    #include <X11/Xutil.h>
+    #include <X11/XKBlib.h>
+    #include <X11/keysym.h>
+#endif
 
 #include "Types.hpp"
 #include "String.hpp"
@@ -21,14 +33,19 @@
 #include "Geom.hpp"
 #include "Coloring.hpp"
 #include "BMR.hpp"
-#include "Win32/Keys.hpp"
-#include "Win32/Misc.hpp"
+
+#if defined(_WIN32)
+    #include "Win32/Keys.hpp"
+    #include "Win32/Misc.hpp"
+#else
+    #include "X11/Window.hpp"
+#endif
 
 
 GlobalVar bool shouldStop = false;
 
 GlobalVar struct {
-    Rect Rect; 
+    ::Rect Rect; 
     Color4 Color;
 
     struct {
@@ -39,11 +56,14 @@ GlobalVar struct {
 
 
 GlobalVar struct {
-    Rect Rect;
+    ::Rect Rect;
     Color4 Color;
     Vec2i Input;
 } box;
 
+GlobalVar U32 xOffset = 0;
+GlobalVar U32 yOffset = 0;
+
 
 #define PLAYER_INIT_X 100
 #define PLAYER_INIT_Y 60
@@ -51,6 +71,7 @@ GlobalVar struct {
 #define PLAYER_HEIGHT 80
 #define PLAYER_COLOR (COLOR_RED + COLOR_BLUE)
 #define PLAYER_SPEED 10
+#define PLAYER_SPIN 0.02  // NOTE(ilya.a): Radians per simulation step.
 
 #define BLOCKS_XOFFSET 300
 #define BLOCKS_YOFFSET 500
@@ -62,6 +83,178 @@ GlobalVar struct {
 #define BLOCK_HEIGHT 80
 #define BLOCK_COLOR COLOR_RED
 
+#define GAME_FRAME_RATE      60
+#define GAME_SIMULATION_RATE 60  // NOTE(ilya.a): Speeds above are per step.
+
+
+/*
+ * Keys, which game is reacting to. Each platform maps own key codes
+ * onto them.
+ */
+enum class GameKey {
+    LEFT,
+    RIGHT,
+    A,
+    D,
+    S,
+    W,
+    H,  // NOTE(ilya.a): Toggles overdraw heatmap.
+    M,  // NOTE(ilya.a): Cycles supersampling.
+};
+
+
+InternalFunc void
+Game_HandleKey(GameKey key, bool pressed)
+{
+    BMR::MarkInput();
+
+    switch (key) {
+        case GameKey::LEFT: {
+            player.Input.LeftPressed = pressed;
+        } break;
+        case GameKey::RIGHT: {
+            player.Input.RightPressed = pressed;
+        } break;
+        case GameKey::H: {
+            if (pressed) {
+                BMR::SetOverdrawHeatmap(!BMR::IsOverdrawHeatmap());
+            }
+        } break;
+        case GameKey::M: {
+            if (pressed) {
+                U32 mode = (U32)BMR::GetSupersampling() * 2;
+                BMR::SetSupersampling(mode > 4 ? BMR::Supersampling::NONE : (BMR::Supersampling)mode);
+            }
+        } break;
+#ifdef COLLISSION_TESTING
+        case GameKey::A: {
+            box.Input.X = pressed ? -1 : 0;
+        } break;
+        case GameKey::D: {
+            box.Input.X = pressed ? +1 : 0;
+        } break;
+        case GameKey::S: {
+            box.Input.Y = pressed ? -1 : 0;
+        } break;
+        case GameKey::W: {
+            box.Input.Y = pressed ? +1 : 0;
+        } break;
+#endif
+        default: {
+        } break;
+    }
+}
+
+
+InternalFunc void
+Game_Init()
+{
+    player.Rect.X = PLAYER_INIT_X;
+    player.Rect.Y = PLAYER_INIT_Y;
+    player.Rect.Width = PLAYER_WIDTH;
+    player.Rect.Height = PLAYER_HEIGHT;
+    player.Color = PLAYER_COLOR;
+
+    box.Rect = Rect(0, 0, 100, 100);
+    box.Color = COLOR_RED;
+
+    BMR::SetClearColor(COLOR_WHITE);
+    BMR::SetSimulationRate(GAME_SIMULATION_RATE);
+}
+
+
+InternalFunc void
+Game_PrintStats()
+{
+    BMR::PacingStats stats = BMR::GetPacingStats();
+
+    char buffer[512];
+    snprintf(
+        buffer, sizeof(buffer),
+        "Frames: %llu, frame time p50 %.2f ms, p99 %.2f ms, slept %.0f ms, spun %.0f ms\n"
+        "Input to present: %llu inputs, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+        (unsigned long long)stats.Frames, stats.FrameTimeP50 / 1e6, stats.FrameTimeP99 / 1e6,
+        stats.SleepTime / 1e6, stats.SpinTime / 1e6,
+        (unsigned long long)stats.Inputs, stats.LatencyP50 / 1e6, stats.LatencyP90 / 1e6,
+        stats.LatencyP99 / 1e6, stats.LatencyMax / 1e6);
+
+#if defined(_WIN32)
+    OutputDebugStringA(buffer);
+#else
+    fputs(buffer, stdout);
+#endif
+}
+
+
+InternalFunc void
+Game_Update()
+{
+    if (player.Input.LeftPressed) {
+        player.Rect.X -= PLAYER_SPEED;
+    }
+
+    if (player.Input.RightPressed) {
+        player.Rect.X += PLAYER_SPEED;
+    }
+
+    xOffset++;
+    yOffset++;
+
+#ifdef COLLISSION_TESTING
+    box.Rect.X += PLAYER_SPEED * box.Input.X;
+    box.Rect.Y += PLAYER_SPEED * box.Input.Y;
+
+    if (player.Rect.IsOverlapping(box.Rect)) {
+        player.Color = COLOR_YELLOW;
+    } else {
+        player.Color = PLAYER_COLOR;
+    }
+#endif
+}
+
+
+/*
+ * Pushes commands of the frame. Called between `BeginDrawing` and
+ * `EndDrawing`.
+ */
+InternalFunc void
+Game_Render()
+{
+    BMR::Clear();
+    BMR::DrawGrad(xOffset, yOffset);
+
+    // NOTE(ilya.a): Player spins around its center.
+    F64 centerX = player.Rect.X + player.Rect.Width / 2.0;
+    F64 centerY = player.Rect.Y + player.Rect.Height / 2.0;
+    BMR::PushTransform(Transform::Translation(centerX, centerY));
+    BMR::PushTransform(Transform::Rotation(xOffset * PLAYER_SPIN));
+    BMR::PushTransform(Transform::Translation(-centerX, -centerY));
+    BMR::DrawRect(player.Rect, player.Color);
+    BMR::PopTransform();
+    BMR::PopTransform();
+    BMR::PopTransform();
+
+    BMR::DrawLine(100, 200, 500, 600, COLOR_BLACK);
+
+#ifdef BLOCKS_RENDERING
+    // NOTE(ilya.a): This is really dog-slow :c
+    for (U32 blockYGrid = 0; blockYGrid < BLOCKS_ROWS_COUNT; ++blockYGrid) {
+        for (U32 blockXGrid = 0; blockXGrid < BLOCKS_PER_ROW; ++blockXGrid) {
+            U32 blockXCoord = blockXGrid * BLOCK_WIDTH + BLOCKS_XOFFSET + BLOCKS_XPADDING * blockXGrid;
+            U32 blockYCoord = blockYGrid * BLOCK_HEIGHT + BLOCKS_YOFFSET + BLOCKS_YPADDING * blockYGrid;
+            BMR::DrawRect(
+                blockXCoord, blockYCoord, BLOCK_WIDTH, BLOCK_HEIGHT, BLOCK_COLOR);
+        }
+    }
+#endif
+
+#ifdef COLLISSION_TESTING
+    BMR::DrawRect(box.Rect, box.Color);
+#endif
+}
+
+
+#if defined(_WIN32)
 
 LRESULT CALLBACK
 Win32_MainWindowProc(HWND   window,
@@ -85,50 +278,35 @@ Win32_MainWindowProc(HWND   window,
             OutputDebugString("WM_PAINT\n");
             BMR::Update(window);
         } break;
-        case WM_KEYDOWN: {
+        case WM_KEYDOWN:
+        case WM_KEYUP: {
+            bool pressed = message == WM_KEYDOWN;
+
             switch (wParam) {
                 case VK_LEFT: {
-                    player.Input.LeftPressed = true;
+                    Game_HandleKey(GameKey::LEFT, pressed);
                 } break;
                 case VK_RIGHT: {
-                    player.Input.RightPressed = true;
+                    Game_HandleKey(GameKey::RIGHT, pressed);
                 } break;
-#ifdef COLLISSION_TESTING
                 case KEY_A: {
-                    box.Input.X = -1;
+                    Game_HandleKey(GameKey::A, pressed);
                 } break;
                 case KEY_D: {
-                    box.Input.X = +1;
+                    Game_HandleKey(GameKey::D, pressed);
                 } break;
                 case KEY_S: {
-                    box.Input.Y = -1;
+                    Game_HandleKey(GameKey::S, pressed);
                 } break;
                 case KEY_W: {
-                    box.Input.Y = +1;
-                } break;
-#endif
-                default: {
-                } break;
-            }
-        } break;
-        case WM_KEYUP: {
-            switch (wParam) {
-                case VK_LEFT: {
-                    player.Input.LeftPressed = false;
-                } break;
-                case VK_RIGHT: {
-                    player.Input.RightPressed = false;
+                    Game_HandleKey(GameKey::W, pressed);
                 } break;
-#ifdef COLLISSION_TESTING
-                case KEY_A:
-                case KEY_D: {
-                    box.Input.X = 0;
+                case KEY_H: {
+                    Game_HandleKey(GameKey::H, pressed);
                 } break;
-                case KEY_W:
-                case KEY_S: {
-                    box.Input.Y = 0;
+                case KEY_M: {
+                    Game_HandleKey(GameKey::M, pressed);
                 } break;
-#endif
                 default: {
                 } break;
             }
@@ -199,21 +377,13 @@ WinMain(_In_ HINSTANCE instance,
 
     ShowWindow(window, showMode);
 
-    U32 xOffset = 0;
-    U32 yOffset = 0;
-
-    player.Rect.X = PLAYER_INIT_X;
-    player.Rect.Y = PLAYER_INIT_Y;
-    player.Rect.Width = PLAYER_WIDTH;
-    player.Rect.Height = PLAYER_HEIGHT;
-    player.Color = PLAYER_COLOR;
-
-    box.Rect = Rect(0, 0, 100, 100);
-    box.Color = COLOR_RED;
-
-    BMR::SetClearColor(COLOR_WHITE);
+    Game_Init();
+    BMR::SetTargetFrameRate(GAME_FRAME_RATE);
 
     while (!shouldStop) {
+        // NOTE(ilya.a): Waiting before polling, so input is as fresh as
+        // possible, when frame is rendered.
+        BMR::WaitForFrame();
 
         MSG message = {};
         while (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE)) {
@@ -226,57 +396,199 @@ WinMain(_In_ HINSTANCE instance,
             DispatchMessageA(&message);
         }
 
-
-        if (player.Input.LeftPressed) {
-            player.Rect.X -= PLAYER_SPEED;
+        while (BMR::StepSimulation()) {
+            Game_Update();
         }
 
-        if (player.Input.RightPressed) {
-            player.Rect.X += PLAYER_SPEED;
-        }
+        BMR::BeginDrawing(window);
+        Game_Render();
+        BMR::EndDrawing();
+    }
+
+    Game_PrintStats();
+    BMR::DeInit();
+
+    return 0;
+}
+
+#else
+
+InternalFunc void
+X11_HandleKey(XKeyEvent *event, bool pressed)
+{
+    switch (XLookupKeysym(event, 0)) {
+        case XK_Left: {
+            Game_HandleKey(GameKey::LEFT, pressed);
+        } break;
+        case XK_Right: {
+            Game_HandleKey(GameKey::RIGHT, pressed);
+        } break;
+        case XK_a: {
+            Game_HandleKey(GameKey::A, pressed);
+        } break;
+        case XK_d: {
+            Game_HandleKey(GameKey::D, pressed);
+        } break;
+        case XK_s: {
+            Game_HandleKey(GameKey::S, pressed);
+        } break;
+        case XK_w: {
+            Game_HandleKey(GameKey::W, pressed);
+        } break;
+        case XK_h: {
+            Game_HandleKey(GameKey::H, pressed);
+        } break;
+        case XK_m: {
+            Game_HandleKey(GameKey::M, pressed);
+        } break;
+        default: {
+        } break;
+    }
+}
 
-#ifdef COLLISSION_TESTING
-        box.Rect.X += PLAYER_SPEED * box.Input.X;
-        box.Rect.Y += PLAYER_SPEED * box.Input.Y;
 
-        if (player.Rect.IsOverlapping(box.Rect)) {
-            player.Color = COLOR_YELLOW;
-        } else {
-            player.Color = PLAYER_COLOR;
+/*
+ * Usage: libsbmr [--frames N] [--fps N] [--heatmap PATH]
+ *
+ * With `--frames` it quits after `N` frames, so it can be run headless
+ * under Xvfb. `--fps` caps frame rate, zero is uncapped. With `--heatmap`
+ * frames are drawn as overdraw heatmap, heatmap of the last one is saved
+ * to `PATH` and its stats are printed.
+ */
+int
+main(int argc, char **argv)
+{
+    U64 frameLimit = 0;
+    U32 frameRate = GAME_FRAME_RATE;
+    CStr heatmapPath = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frameLimit = strtoull(argv[i + 1], nullptr, 10);
+        } else if (strcmp(argv[i], "--fps") == 0) {
+            frameRate = (U32)strtoul(argv[i + 1], nullptr, 10);
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            heatmapPath = argv[i + 1];
         }
-#endif
+    }
 
-        BMR::BeginDrawing(window);
+    Display *display = XOpenDisplay(nullptr);
+    if (display == nullptr) {
+        fputs("Failed to open X display!\n", stderr);
+        return 1;
+    }
 
-        BMR::Clear();
-        BMR::DrawGrad(xOffset, yOffset);
-        BMR::DrawRect(player.Rect, player.Color);
+    PersistVar CStr WINDOW_TITLE = "Breakout";
 
-        BMR::DrawLine(100, 200, 500, 600);
+    S32 screen = DefaultScreen(display);
+    ::Window window = XCreateSimpleWindow(
+        display, RootWindow(display, screen),
+        0, 0, 1280, 720, 0,
+        BlackPixel(display, screen), BlackPixel(display, screen));
 
-#ifdef BLOCKS_RENDERING
-        // NOTE(ilya.a): This is really dog-slow :c
-        for (U32 blockYGrid = 0; blockYGrid < BLOCKS_ROWS_COUNT; ++blockYGrid) {
-            for (U32 blockXGrid = 0; blockXGrid < BLOCKS_PER_ROW; ++blockXGrid) {
-                U32 blockXCoord = blockXGrid * BLOCK_WIDTH + BLOCKS_XOFFSET + BLOCKS_XPADDING * blockXGrid;
-                U32 blockYCoord = blockYGrid * BLOCK_HEIGHT + BLOCKS_YOFFSET + BLOCKS_YPADDING * blockYGrid;
-                BMR::DrawRect(
-                    blockXCoord, blockYCoord, BLOCK_WIDTH, BLOCK_HEIGHT, BLOCK_COLOR);
+    XStoreName(display, window, WINDOW_TITLE);
+    XSelectInput(
+        display, window, 
+        ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask);
+
+    // NOTE(ilya.a): Asks window manager to tell us about closing instead
+    // of killing connection.
+    Atom deleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(display, window, &deleteWindow, 1);
+
+    // NOTE(ilya.a): Otherwise key release and press are sent for every 
+    // auto repeat, and player stops between them.
+    XkbSetDetectableAutoRepeat(display, True, nullptr);
+
+    XMapWindow(display, window);
+
+    BMR::Init();
+    if (!BMR::X11_Attach(display, window)) {
+        fputs("Failed to attach renderer to window!\n", stderr);
+        return 1;
+    }
+    BMR::Resize(1280, 720);
+    BMR::SetOverdrawHeatmap(heatmapPath != nullptr);
+
+    Game_Init();
+    BMR::SetTargetFrameRate(frameRate);
+
+    for (U64 frame = 0; !shouldStop; ++frame) {
+        // NOTE(ilya.a): Waiting before polling, so input is as fresh as
+        // possible, when frame is rendered.
+        BMR::WaitForFrame();
+
+        while (XPending(display) > 0) {
+            XEvent event;
+            XNextEvent(display, &event);
+
+            switch (event.type) {
+                case ConfigureNotify: {
+                    S32 width = event.xconfigure.width;
+                    S32 height = event.xconfigure.height;
+                    if (width != (S32)BMR::GetBackbuffer()->Width 
+                        || height != (S32)BMR::GetBackbuffer()->Height) {
+                        BMR::Resize(width, height);
+                    }
+                } break;
+                case Expose: {
+                    if (event.xexpose.count == 0) {
+                        BMR::Update(display, window);
+                    }
+                } break;
+                case KeyPress:
+                case KeyRelease: {
+                    X11_HandleKey(&event.xkey, event.type == KeyPress);
+                } break;
+                case ClientMessage: {
+                    if ((Atom)event.xclient.data.l[0] == deleteWindow) {
+                        shouldStop = true;
+                    }
+                } break;
+                default: {
+                } break;
             }
         }
-#endif
 
-#ifdef COLLISSION_TESTING
-        BMR::DrawRect(box.Rect, box.Color);
-#endif
+        while (BMR::StepSimulation()) {
+            Game_Update();
+        }
 
+        BMR::BeginDrawing(display, window);
+        Game_Render();
         BMR::EndDrawing();
 
-        xOffset++;
-        yOffset++;
+        if (frameLimit != 0 && frame + 1 >= frameLimit) {
+            shouldStop = true;
+        }
+    }
+
+    if (heatmapPath != nullptr) {
+        BMR::OverdrawStats stats = BMR::GetOverdrawStats();
+        printf(
+            "Overdraw: average %.2f, max %u, covered %llu of %llu pixels\n"
+            "  clear %llu, line %llu, rect %llu, gradient %llu, composite %llu, "
+            "canvas %llu, post-process %llu\n",
+            stats.AverageOverdraw, stats.MaxOverdraw,
+            (unsigned long long)stats.PixelsCovered, (unsigned long long)stats.Pixels,
+            (unsigned long long)stats.ClearPixels, (unsigned long long)stats.LinePixels,
+            (unsigned long long)stats.RectPixels, (unsigned long long)stats.GradientPixels,
+            (unsigned long long)stats.CompositePixels, (unsigned long long)stats.CanvasPixels,
+            (unsigned long long)stats.PostProcessPixels);
+
+        if (!BMR::SaveOverdrawHeatmap(heatmapPath)) {
+            fputs("Failed to save overdraw heatmap!\n", stderr);
+        }
     }
 
+    Game_PrintStats();
+
+    BMR::X11_Detach();
     BMR::DeInit();
 
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+
     return 0;
 }
+
+#endif
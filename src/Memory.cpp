@@ -0,0 +1,88 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Memory.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Memory.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+namespace BMR {
+
+    void *
+    Memory_Allocate(Size size) noexcept
+    {
+        Size granularity = 0;
+        void *p = Memory_Reserve(size, false, &granularity);
+
+        if (p != nullptr && !Memory_Commit(p, AlignUp(size, granularity), false)) {
+            Memory_Release(p, size);
+            p = nullptr;
+        }
+
+        return p;
+    }
+
+    void 
+    Memory_Free(void *p, Size size) noexcept
+    {
+        if (p != nullptr) {
+            Memory_Release(p, size);
+        }
+    }
+
+    bool 
+    VirtualBuffer_Reserve(VirtualBuffer *b, Size size, 
+                          bool preferHugePages) noexcept
+    {
+        b->Base = (U8 *)Memory_Reserve(size, preferHugePages, &b->Granularity);
+        b->Reserved = b->Base != nullptr ? AlignUp(size, b->Granularity) : 0;
+        b->Committed = 0;
+        b->PrefersHugePages = preferHugePages;
+        return b->Base != nullptr;
+    }
+
+    bool 
+    VirtualBuffer_Resize(VirtualBuffer *b, Size size) noexcept
+    {
+        if (b->Base == nullptr || size > b->Reserved) {
+            return false;
+        }
+
+        Size needed = AlignUp(size, b->Granularity);
+
+        if (needed > b->Committed) {
+            if (!Memory_Commit(b->Base + b->Committed, needed - b->Committed, b->PrefersHugePages)) {
+                return false;
+            }
+            b->Committed = needed;
+        } else if (b->Committed - needed > b->Committed / 4) {
+            // NOTE(ilya.a): Only shrink, when at least quarter of memory is
+            // unused. Interactive resize is jittering back and forth by few
+            // rows, which must not cause page faults every time.
+            if (Memory_Decommit(b->Base + needed, b->Committed - needed)) {
+                b->Committed = needed;
+            }
+        }
+
+        return true;
+    }
+
+    void 
+    VirtualBuffer_Release(VirtualBuffer *b) noexcept
+    {
+        if (b->Base != nullptr) {
+            Memory_Release(b->Base, b->Reserved);
+        }
+
+        *b = VirtualBuffer{};
+    }
+
+};  // namespace BMR
@@ -0,0 +1,85 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Memory.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Virtual memory helpers. Platform specific primitives are implemented in
+ * `Win32/Memory.cpp` and `Linux/Memory.cpp`.
+ * */
+
+#ifndef SBMR_MEMORY_HPP_INCLUDED
+#define SBMR_MEMORY_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+#define BMR_CACHE_LINE_SIZE 64
+
+
+constexpr Size
+AlignUp(Size value, Size alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+namespace BMR {
+
+    /*
+     * Reserves address space without backing it with memory. When 
+     * `preferHugePages` is set, it's aligned, so memory, which is committed
+     * with the same flag, can be backed by huge pages. Sets `granularity`
+     * to size of page, commits must be aligned to.
+     */
+    void *Memory_Reserve(Size size, bool preferHugePages, 
+                         Out Size *granularity) noexcept;
+
+    bool Memory_Commit(void *p, Size size, bool preferHugePages) noexcept;
+    bool Memory_Decommit(void *p, Size size) noexcept;
+    void Memory_Release(void *p, Size size) noexcept;
+
+    /*
+     * Reserves and commits `size` bytes at once.
+     */
+    void *Memory_Allocate(Size size) noexcept;
+    void Memory_Free(void *p, Size size) noexcept;
+
+    /*
+     * Maps whole file into memory for reading. Returns `nullptr` for empty
+     * or missing file.
+     */
+    void *Memory_MapFile(CStr path, Out Size *size) noexcept;
+    void Memory_UnmapFile(void *p, Size size) noexcept;
+
+
+    /*
+     * Reserved region, which committed part can grow and shrink in place.
+     * Pointer to the memory stays the same during whole lifetime.
+     */
+    struct VirtualBuffer {
+        U8  *Base;
+        Size Reserved;
+        Size Committed;
+        Size Granularity;
+        bool PrefersHugePages;
+    };
+
+    bool VirtualBuffer_Reserve(VirtualBuffer *b, Size size, 
+                               bool preferHugePages) noexcept;
+
+    /*
+     * Makes sure first `size` bytes are committed. Tail is decommitted only
+     * if it's big enough, so memory isn't thrashed by small changes.
+     */
+    bool VirtualBuffer_Resize(VirtualBuffer *b, Size size) noexcept;
+
+    void VirtualBuffer_Release(VirtualBuffer *b) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_MEMORY_HPP_INCLUDED
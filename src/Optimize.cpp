@@ -0,0 +1,254 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Optimize.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+
+#include "Optimize.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Lin.hpp"
+#include "Geom.hpp"
+#include "Surface.hpp"
+#include "Command.hpp"
+
+
+#define BMR_OPTIMIZE_MAX_COMMAND_SIZE 128
+
+static_assert(sizeof(BMR::RenderCommand<BMR::_DrawGradient_Payload>) <= BMR_OPTIMIZE_MAX_COMMAND_SIZE);
+static_assert(sizeof(BMR::RenderCommand<BMR::_DrawTarget_Payload>) <= BMR_OPTIMIZE_MAX_COMMAND_SIZE);
+static_assert(sizeof(BMR::RenderCommand<BMR::_DrawQuad_Payload>) <= BMR_OPTIMIZE_MAX_COMMAND_SIZE);
+static_assert(sizeof(BMR::RenderCommand<BMR::_DrawSprite_Payload>) <= BMR_OPTIMIZE_MAX_COMMAND_SIZE);
+
+
+namespace BMR {
+
+    InternalFunc U64
+    _GetWork(const U8 *command, const Clip &bounds) noexcept
+    {
+        if (bounds.IsEmpty()) {
+            return 0;
+        }
+
+        S64 w = bounds.X1 - bounds.X0;
+        S64 h = bounds.Y1 - bounds.Y0;
+
+        if (*((const RenderCommandType *)command) == RenderCommandType::LINE) {
+            return (U64)(w > h ? w : h);
+        }
+        return (U64)(w * h);
+    }
+
+    /*
+     * Command, which replaces every pixel of target, so nothing drawn
+     * before it is visible.
+     */
+    InternalFunc bool
+    _IsOverwritingTarget(const U8 *command, const Clip &bounds, const Clip &target) noexcept
+    {
+        RenderCommandType type = *((const RenderCommandType *)command);
+
+        return (type == RenderCommandType::CLEAR || type == RenderCommandType::RECT)
+            && !target.IsEmpty()
+            && bounds.X0 == target.X0 && bounds.Y0 == target.Y0
+            && bounds.X1 == target.X1 && bounds.Y1 == target.Y1;
+    }
+
+    /*
+     * Merges `b` into `a`, if both have same color and their union is
+     * a rect.
+     */
+    InternalFunc bool
+    _MergeRects(_DrawRect_Payload *a, const _DrawRect_Payload &b) noexcept
+    {
+        if (memcmp(&a->Color, &b.Color, sizeof(Color4)) != 0) {
+            return false;
+        }
+
+        S64 ax0 = a->Rect.X, ax1 = ax0 + a->Rect.Width;
+        S64 ay0 = a->Rect.Y, ay1 = ay0 + a->Rect.Height;
+        S64 bx0 = b.Rect.X,  bx1 = bx0 + b.Rect.Width;
+        S64 by0 = b.Rect.Y,  by1 = by0 + b.Rect.Height;
+
+        bool isRow = ay0 == by0 && ay1 == by1 && ax0 <= bx1 && bx0 <= ax1;
+        bool isColumn = ax0 == bx0 && ax1 == bx1 && ay0 <= by1 && by0 <= ay1;
+        bool isInside = bx0 >= ax0 && bx1 <= ax1 && by0 >= ay0 && by1 <= ay1;
+        bool isOutside = ax0 >= bx0 && ax1 <= bx1 && ay0 >= by0 && ay1 <= by1;
+
+        if (!isRow && !isColumn && !isInside && !isOutside) {
+            return false;
+        }
+
+        S64 x0 = ax0 < bx0 ? ax0 : bx0, x1 = ax1 > bx1 ? ax1 : bx1;
+        S64 y0 = ay0 < by0 ? ay0 : by0, y1 = ay1 > by1 ? ay1 : by1;
+        if (x1 - x0 > MAX_U32 || y1 - y0 > MAX_U32) {
+            return false;
+        }
+
+        a->Rect = Rect((U32)x0, (U32)y0, (U32)(x1 - x0), (U32)(y1 - y0));
+        return true;
+    }
+
+    struct _RunEntry {
+        Size Offset;
+        Size Bytes;
+        RenderCommandType Type;
+        Clip Bounds;
+    };
+
+    /*
+     * Groups commands of the run by type, keeping order of first
+     * appearance of each type. Commands of run don't overlap, so any
+     * order gives same pixels.
+     */
+    InternalFunc void
+    _SortRun(U8 *commands, const _RunEntry *run, U32 count,
+             Out QueueStats *stats) noexcept
+    {
+        if (count < 2) {
+            return;
+        }
+
+        U32 order[BMR_OPTIMIZE_WINDOW];
+        bool isPlaced[BMR_OPTIMIZE_WINDOW] = {};
+        U32 placed = 0;
+        bool isChanged = false;
+
+        for (U32 i = 0; i < count; ++i) {
+            if (isPlaced[i]) {
+                continue;
+            }
+
+            for (U32 j = i; j < count; ++j) {
+                if (!isPlaced[j] && run[j].Type == run[i].Type) {
+                    isPlaced[j] = true;
+                    isChanged |= j != placed;
+                    stats->Reordered += j != placed;
+                    order[placed++] = j;
+                }
+            }
+        }
+
+        if (!isChanged) {
+            return;
+        }
+
+        U8 scratch[BMR_OPTIMIZE_WINDOW * BMR_OPTIMIZE_MAX_COMMAND_SIZE];
+        Size cursor = 0;
+
+        for (U32 i = 0; i < count; ++i) {
+            const _RunEntry &e = run[order[i]];
+            memcpy(scratch + cursor, commands + e.Offset, e.Bytes);
+            cursor += e.Bytes;
+        }
+
+        memcpy(commands + run[0].Offset, scratch, cursor);
+    }
+
+    U64
+    Optimize_Commands(U8 *commands, Size *size, U64 count,
+                      const Clip &target, Out QueueStats *stats) noexcept
+    {
+        *stats = QueueStats{};
+        stats->Submitted = count;
+
+        // NOTE(ilya.a): Find the last command, which overwrites target.
+        U64 firstVisible = 0;
+        Size cursor = 0;
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            const U8 *command = commands + cursor;
+            Clip bounds = Command_GetBounds(command, target);
+
+            stats->PixelsSubmitted += _GetWork(command, bounds);
+            if (_IsOverwritingTarget(command, bounds, target)) {
+                firstVisible = commandIdx;
+            }
+
+            cursor += Command_GetSize(*((const RenderCommandType *)command));
+        }
+
+        // NOTE(ilya.a): Commands are compacted towards beginning of queue,
+        // write cursor is never ahead of read cursor.
+        Size read = 0;
+        Size write = 0;
+        Size previous = 0;
+        bool hasPrevious = false;
+        U64 kept = 0;
+
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            U8 *command = commands + read;
+            RenderCommandType type = *((const RenderCommandType *)command);
+            Size commandSize = Command_GetSize(type);
+            read += commandSize;
+
+            if (commandIdx < firstVisible) {
+                stats->Overdrawn++;
+                continue;
+            }
+
+            Clip bounds = Command_GetBounds(command, target);
+            if (bounds.IsEmpty()) {
+                stats->Culled++;
+                continue;
+            }
+
+            if (type == RenderCommandType::RECT && hasPrevious
+                && *((const RenderCommandType *)(commands + previous)) == RenderCommandType::RECT) {
+                auto *a = (RenderCommand<_DrawRect_Payload> *)(commands + previous);
+                auto *b = (const RenderCommand<_DrawRect_Payload> *)command;
+
+                if (_MergeRects(&a->Payload, b->Payload)) {
+                    stats->Merged++;
+                    continue;
+                }
+            }
+
+            memmove(commands + write, command, commandSize);
+            previous = write;
+            hasPrevious = true;
+            write += commandSize;
+            kept++;
+        }
+
+        *size = write;
+
+        // NOTE(ilya.a): Group independent commands by type.
+        _RunEntry run[BMR_OPTIMIZE_WINDOW];
+        U32 runCount = 0;
+
+        cursor = 0;
+        for (U64 commandIdx = 0; commandIdx < kept; ++commandIdx) {
+            const U8 *command = commands + cursor;
+            RenderCommandType type = *((const RenderCommandType *)command);
+            Clip bounds = Command_GetBounds(command, target);
+
+            stats->PixelsExecuted += _GetWork(command, bounds);
+
+            bool isIndependent = runCount < BMR_OPTIMIZE_WINDOW;
+            for (U32 i = 0; isIndependent && i < runCount; ++i) {
+                isIndependent = run[i].Bounds.Intersect(bounds).IsEmpty();
+            }
+
+            if (!isIndependent) {
+                _SortRun(commands, run, runCount, stats);
+                runCount = 0;
+            }
+
+            run[runCount++] = _RunEntry{cursor, Command_GetSize(type), type, bounds};
+            cursor += Command_GetSize(type);
+        }
+        _SortRun(commands, run, runCount, stats);
+
+        stats->Executed = kept;
+        return kept;
+    }
+
+};  // namespace BMR
@@ -0,0 +1,48 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Optimize.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Command queue optimizer. Rewrites queue before rasterization, so that
+ * result is the same, but less work is done.
+ * */
+
+#ifndef SBMR_OPTIMIZE_HPP_INCLUDED
+#define SBMR_OPTIMIZE_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Raster.hpp"
+#include "BMR.hpp"
+
+
+// NOTE(ilya.a): How many mutually independent commands are reordered at
+// once. Each command is checked against all of them, so it keeps the pass
+// linear.
+#define BMR_OPTIMIZE_WINDOW 16
+
+
+namespace BMR {
+
+    /*
+     * Optimizes `count` commands at `commands` in place, which are going
+     * to be rasterized into `target`. Size of queue in bytes is updated,
+     * new count is returned.
+     *
+     * - Everything before the last command, which overwrites whole target,
+     *   is dropped.
+     * - Commands, which cover nothing inside of target, are dropped.
+     * - Adjacent rects of the same color, union of which is a rect, are
+     *   merged.
+     * - Runs of commands, which don't overlap each other, are grouped by
+     *   type.
+     */
+    U64 Optimize_Commands(U8 *commands, Size *size, U64 count,
+                          const Clip &target, Out QueueStats *stats) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_OPTIMIZE_HPP_INCLUDED
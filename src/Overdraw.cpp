@@ -0,0 +1,338 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Overdraw.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Overdraw.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "Format.hpp"
+#include "Memory.hpp"
+#include "Command.hpp"
+#include "Debug.hpp"
+
+
+#define BMR_OVERDRAW_SPAN 256  // NOTE(ilya.a): Pixels, which are shaded at once.
+#define BMR_OVERDRAW_MAX_PIXELS ((Size)BMR_FRAMEBUFFER_MAX_WIDTH * BMR_FRAMEBUFFER_MAX_HEIGHT)
+
+
+namespace BMR {
+
+    // NOTE(ilya.a): Black is never written, then blue, green, yellow, red,
+    // and white for `BMR_OVERDRAW_MAX_SHADE` writes or more.
+    GlobalVar constexpr Color4 OverdrawShades[BMR_OVERDRAW_MAX_SHADE + 1] = {
+        Color4(  0,   0,   0, MAX_U8),
+        Color4(  0,  32, 160, MAX_U8),
+        Color4(  0, 144, 255, MAX_U8),
+        Color4(  0, 200,  64, MAX_U8),
+        Color4(224, 224,   0, MAX_U8),
+        Color4(255, 128,   0, MAX_U8),
+        Color4(255,   0,   0, MAX_U8),
+        Color4(255,   0, 192, MAX_U8),
+        Color4(255, 255, 255, MAX_U8),
+    };
+
+    InternalFunc inline U16 *
+    _GetCountAddress(const Overdraw *o, S64 x, S64 y) noexcept
+    {
+        S64 width = o->Target.X1 - o->Target.X0;
+        return (U16 *)o->Counts.Base + (y - o->Target.Y0) * width + (x - o->Target.X0);
+    }
+
+    InternalFunc void
+    _CountArea(Overdraw *o, const Clip &area, Out U64 *written) noexcept
+    {
+        for (S64 y = area.Y0; y < area.Y1; ++y) {
+            U16 *count = _GetCountAddress(o, area.X0, y);
+
+            for (S64 x = 0; x < area.X1 - area.X0; ++x) {
+                count[x] += count[x] != MAX_U16;
+            }
+        }
+
+        *written += (U64)((area.X1 - area.X0) * (area.Y1 - area.Y0));
+    }
+
+    /*
+     * Line, quad or sprite is drawn into probe, which is zero everywhere,
+     * then every pixel it has plotted is counted and cleared back.
+     */
+    InternalFunc void
+    _CountPlotted(Overdraw *o, const Clip &area, const U8 *command,
+                  Out U64 *written) noexcept
+    {
+        S64 width = o->Target.X1 - o->Target.X0;
+        S64 height = o->Target.Y1 - o->Target.Y0;
+
+        if (!VirtualBuffer_Resize(&o->Probe, (Size)(width * height) * sizeof(Color4))) {
+            Debug_Print("Failed to commit memory for overdraw probe!\n");
+            return;
+        }
+
+        Surface probe = {};
+        probe.Buffer = o->Probe.Base;
+        probe.Width = (U64)width;
+        probe.Height = (U64)height;
+        probe.Pitch = (U64)width * sizeof(Color4);
+        probe.Format = PixelFormat::BGRA8888;
+        probe.X = o->Target.X0;
+        probe.Y = o->Target.Y0;
+
+        switch (*((const RenderCommandType *)command)) {
+            case (RenderCommandType::LINE): {
+                const _DrawLine_Payload &p = ((const RenderCommand<_DrawLine_Payload> *)command)->Payload;
+                Raster_Line(&probe, area, p.p1, p.p2, COLOR_WHITE, p.Mode);
+            } break;
+            case (RenderCommandType::QUAD): {
+                const _DrawQuad_Payload &p = ((const RenderCommand<_DrawQuad_Payload> *)command)->Payload;
+                Raster_Quad(&probe, area, Raster_GetAffineMap(p.Transform, p.Rect), COLOR_WHITE);
+            } break;
+            case (RenderCommandType::SPRITE): {
+                // NOTE(ilya.a): Sprite covers the same pixels as quad.
+                const _DrawSprite_Payload &p = ((const RenderCommand<_DrawSprite_Payload> *)command)->Payload;
+                Raster_Quad(&probe, area, Raster_GetAffineMap(p.Transform, Command_GetSpriteRect(p)), COLOR_WHITE);
+            } break;
+            default: {
+            } break;
+        }
+
+        for (S64 y = area.Y0; y < area.Y1; ++y) {
+            U32 *pixel = (U32 *)GetPixelAddress(&probe, area.X0, y);
+            U16 *count = _GetCountAddress(o, area.X0, y);
+
+            for (S64 x = 0; x < area.X1 - area.X0; ++x) {
+                if (pixel[x] != 0) {
+                    pixel[x] = 0;
+                    count[x] += count[x] != MAX_U16;
+                    (*written)++;
+                }
+            }
+        }
+    }
+
+    void
+    Overdraw_Count(Overdraw *o, const U8 *commands, U64 count,
+                   const Clip &target) noexcept
+    {
+        o->Stats = OverdrawStats{};
+        o->Target = target.IsEmpty() ? Clip{} : target;
+
+        S64 width = o->Target.X1 - o->Target.X0;
+        S64 height = o->Target.Y1 - o->Target.Y0;
+        Size size = (Size)(width * height) * sizeof(U16);
+
+        if ((o->Counts.Base == nullptr
+             && !VirtualBuffer_Reserve(&o->Counts, BMR_OVERDRAW_MAX_PIXELS * sizeof(U16), false))
+            || (o->Probe.Base == nullptr
+                && !VirtualBuffer_Reserve(&o->Probe, BMR_OVERDRAW_MAX_PIXELS * sizeof(Color4), false))) {
+            Debug_Print("Failed to reserve memory for overdraw heatmap!\n");
+            o->Target = Clip{};
+            return;
+        }
+
+        if (!VirtualBuffer_Resize(&o->Counts, size)) {
+            Debug_Print("Failed to commit memory for overdraw heatmap!\n");
+            o->Target = Clip{};
+            return;
+        }
+        memset(o->Counts.Base, 0, size);
+
+        OverdrawStats &stats = o->Stats;
+        stats.Pixels = (U64)(width * height);
+
+        const U8 *cursor = commands;
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            Clip bounds = Command_GetBounds(cursor, o->Target);
+
+            if (!bounds.IsEmpty()) {
+                switch (type) {
+                    case (RenderCommandType::CLEAR): {
+                        _CountArea(o, bounds, &stats.ClearPixels);
+                    } break;
+                    case (RenderCommandType::LINE): {
+                        _CountPlotted(o, bounds, cursor, &stats.LinePixels);
+                    } break;
+                    case (RenderCommandType::RECT): {
+                        _CountArea(o, bounds, &stats.RectPixels);
+                    } break;
+                    case (RenderCommandType::QUAD): {
+                        _CountPlotted(o, bounds, cursor, &stats.RectPixels);
+                    } break;
+                    case (RenderCommandType::GRADIENT):
+                    case (RenderCommandType::LINEAR_GRADIENT):
+                    case (RenderCommandType::RADIAL_GRADIENT): {
+                        _CountArea(o, bounds, &stats.GradientPixels);
+                    } break;
+                    case (RenderCommandType::COMPOSITE): {
+                        _CountArea(o, bounds, &stats.CompositePixels);
+                    } break;
+                    case (RenderCommandType::SPRITE): {
+                        _CountPlotted(o, bounds, cursor, &stats.CompositePixels);
+                    } break;
+                    case (RenderCommandType::CANVAS): {
+                        _CountArea(o, bounds, &stats.CanvasPixels);
+                    } break;
+                    case (RenderCommandType::BLUR): {
+                        _CountArea(o, bounds, &stats.PostProcessPixels);
+                    } break;
+                    case (RenderCommandType::DOWNSAMPLE): {
+                        // NOTE(ilya.a): Only top left quarter is written.
+                        Clip quarter = {
+                            bounds.X0, bounds.Y0,
+                            bounds.X0 + (bounds.X1 - bounds.X0) / 2,
+                            bounds.Y0 + (bounds.Y1 - bounds.Y0) / 2,
+                        };
+                        if (!quarter.IsEmpty()) {
+                            _CountArea(o, quarter, &stats.PostProcessPixels);
+                        }
+                    } break;
+                    case (RenderCommandType::NOP):
+                    default: {
+                    } break;
+                }
+            }
+
+            cursor += Command_GetSize(type);
+        }
+
+        const U16 *counts = (const U16 *)o->Counts.Base;
+        for (U64 i = 0; i < stats.Pixels; ++i) {
+            stats.PixelsWritten += counts[i];
+            stats.PixelsCovered += counts[i] != 0;
+            stats.MaxOverdraw = counts[i] > stats.MaxOverdraw ? counts[i] : stats.MaxOverdraw;
+        }
+
+        if (stats.PixelsCovered != 0) {
+            stats.AverageOverdraw = (F32)((F64)stats.PixelsWritten / (F64)stats.PixelsCovered);
+        }
+    }
+
+    Color4
+    Overdraw_GetShade(U32 count) noexcept
+    {
+        return OverdrawShades[count < BMR_OVERDRAW_MAX_SHADE ? count : BMR_OVERDRAW_MAX_SHADE];
+    }
+
+    /*
+     * Shades `count` pixels of row `y`, starting at `x`.
+     */
+    InternalFunc void
+    _Shade(const Overdraw *o, S64 x, S64 y, S64 count, Out Color4 *out) noexcept
+    {
+        const U16 *counts = _GetCountAddress(o, x, y);
+
+        for (S64 i = 0; i < count; ++i) {
+            out[i] = Overdraw_GetShade(counts[i]);
+        }
+    }
+
+    void
+    Overdraw_Resolve(const Overdraw *o, Surface *dst) noexcept
+    {
+        Clip r = o->Target.Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        Color4 span[BMR_OVERDRAW_SPAN];
+
+        for (S64 y = r.Y0; y < r.Y1; ++y) {
+            for (S64 x = r.X0; x < r.X1; x += BMR_OVERDRAW_SPAN) {
+                S64 count = r.X1 - x < BMR_OVERDRAW_SPAN ? r.X1 - x : BMR_OVERDRAW_SPAN;
+
+                _Shade(o, x, y, count, span);
+                Format_StoreSpan(dst, x, y, span, count);
+            }
+        }
+    }
+
+    InternalFunc void
+    _Write16(U8 *p, U16 value) noexcept
+    {
+        p[0] = (U8)value;
+        p[1] = (U8)(value >> 8);
+    }
+
+    InternalFunc void
+    _Write32(U8 *p, U32 value) noexcept
+    {
+        p[0] = (U8)value;
+        p[1] = (U8)(value >> 8);
+        p[2] = (U8)(value >> 16);
+        p[3] = (U8)(value >> 24);
+    }
+
+    bool
+    Overdraw_Save(const Overdraw *o, CStr path) noexcept
+    {
+        if (o->Target.IsEmpty()) {
+            Debug_Print("Nothing to save, overdraw was not counted!\n");
+            return false;
+        }
+
+        S64 width = o->Target.X1 - o->Target.X0;
+        S64 height = o->Target.Y1 - o->Target.Y0;
+
+        FILE *file = fopen(path, "wb");
+        if (file == nullptr) {
+            Debug_Print("Failed to open file for overdraw heatmap!\n");
+            return false;
+        }
+
+        // NOTE(ilya.a): BITMAPFILEHEADER and BITMAPINFOHEADER. Height is
+        // negative, so rows are stored top-down, same as in memory.
+        // [https://learn.microsoft.com/en-us/windows/win32/api/wingdi/ns-wingdi-bitmapinfoheader]
+        U8 header[54] = {};
+        U32 imageSize = (U32)(width * height) * sizeof(Color4);
+        header[0] = 'B';
+        header[1] = 'M';
+        _Write32(header + 2, sizeof(header) + imageSize);
+        _Write32(header + 10, sizeof(header));
+        _Write32(header + 14, 40);
+        _Write32(header + 18, (U32)width);
+        _Write32(header + 22, (U32)-height);
+        _Write16(header + 26, 1);
+        _Write16(header + 28, 32);
+        _Write32(header + 34, imageSize);
+
+        bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+        Color4 span[BMR_OVERDRAW_SPAN];
+        for (S64 y = o->Target.Y0; ok && y < o->Target.Y1; ++y) {
+            for (S64 x = o->Target.X0; ok && x < o->Target.X1; x += BMR_OVERDRAW_SPAN) {
+                S64 count = o->Target.X1 - x < BMR_OVERDRAW_SPAN ? o->Target.X1 - x : BMR_OVERDRAW_SPAN;
+
+                _Shade(o, x, y, count, span);
+                ok = fwrite(span, sizeof(Color4), (Size)count, file) == (Size)count;
+            }
+        }
+
+        ok = fclose(file) == 0 && ok;
+        if (!ok) {
+            Debug_Print("Failed to write overdraw heatmap!\n");
+        }
+        return ok;
+    }
+
+    void
+    Overdraw_Release(Overdraw *o) noexcept
+    {
+        VirtualBuffer_Release(&o->Counts);
+        VirtualBuffer_Release(&o->Probe);
+        *o = Overdraw{};
+    }
+
+};  // namespace BMR
@@ -0,0 +1,61 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Overdraw.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Overdraw heatmap. Instead of rasterizing commands, counts how many of
+ * them wrote each pixel, then shades pixels by their count.
+ * */
+
+#ifndef SBMR_OVERDRAW_HPP_INCLUDED
+#define SBMR_OVERDRAW_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Raster.hpp"
+#include "Memory.hpp"
+#include "BMR.hpp"
+
+
+namespace BMR {
+
+    struct Overdraw {
+        VirtualBuffer Counts;  // NOTE(ilya.a): `U16` per pixel, saturating.
+        VirtualBuffer Probe;   // NOTE(ilya.a): `BGRA8888`, lines are drawn into it.
+        Clip Target;
+        OverdrawStats Stats;
+    };
+
+    /*
+     * Counts writes of `count` commands over `target`. Fills, gradients,
+     * composites and post-processing write their whole bounds, lines,
+     * quads and sprites write pixels they are plotting.
+     */
+    void Overdraw_Count(Overdraw *o, const U8 *commands, U64 count,
+                        const Clip &target) noexcept;
+
+    /*
+     * Color of pixel, which was written `count` times.
+     */
+    Color4 Overdraw_GetShade(U32 count) noexcept;
+
+    /*
+     * Writes shades of the last counted frame into `dst`.
+     */
+    void Overdraw_Resolve(const Overdraw *o, Surface *dst) noexcept;
+
+    /*
+     * Writes shades of the last counted frame as 32-bit BMP file.
+     */
+    bool Overdraw_Save(const Overdraw *o, CStr path) noexcept;
+
+    void Overdraw_Release(Overdraw *o) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_OVERDRAW_HPP_INCLUDED
@@ -0,0 +1,232 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Pacing.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Pacing.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Time.hpp"
+
+
+// NOTE(ilya.a): Spin margin starts big enough for default timer tick of
+// Linux, then follows how late sleep actually wakes up.
+#define BMR_PACING_INITIAL_SPIN (2 * BMR_NS_PER_MS)
+#define BMR_PACING_MIN_SPIN     (BMR_NS_PER_MS / 4)
+#define BMR_PACING_MAX_SPIN     (4 * BMR_NS_PER_MS)
+
+
+namespace BMR {
+
+    void
+    Pacing_Reset(Pacer *p) noexcept
+    {
+        *p = Pacer{};
+        p->SpinMargin = BMR_PACING_INITIAL_SPIN;
+    }
+
+    void
+    Pacing_SetFrameRate(Pacer *p, U32 fps) noexcept
+    {
+        p->FramePeriod = fps != 0 ? BMR_NS_PER_SECOND / fps : 0;
+        p->Deadline = 0;
+    }
+
+    void
+    Pacing_SetStepRate(Pacer *p, U32 hz) noexcept
+    {
+        p->StepPeriod = hz != 0 ? BMR_NS_PER_SECOND / hz : 0;
+        p->Accumulator = 0;
+    }
+
+    /*
+     * Sleeps, while deadline is further than spin margin, then spins.
+     */
+    InternalFunc void
+    _WaitUntil(Pacer *p, U64 deadline) noexcept
+    {
+        U64 now = Time_Now();
+
+        if (deadline > now + p->SpinMargin) {
+            U64 wake = deadline - p->SpinMargin;
+            Time_Sleep(wake - now);
+
+            U64 woke = Time_Now();
+            p->SleepTime += woke - now;
+
+            // NOTE(ilya.a): Margin decays slowly, but grows at once, when
+            // sleep was later than it, so missed deadlines are rare.
+            U64 late = woke > wake ? woke - wake : 0;
+            U64 margin = p->SpinMargin - p->SpinMargin / 16;
+            margin = late + late / 4 > margin ? late + late / 4 : margin;
+            margin = margin < BMR_PACING_MIN_SPIN ? BMR_PACING_MIN_SPIN : margin;
+            p->SpinMargin = margin > BMR_PACING_MAX_SPIN ? BMR_PACING_MAX_SPIN : margin;
+
+            now = woke;
+        }
+
+        U64 spin = now;
+        while (now < deadline) {
+            Time_Relax();
+            now = Time_Now();
+        }
+        p->SpinTime += now - spin;
+    }
+
+    void
+    Pacing_WaitForFrame(Pacer *p) noexcept
+    {
+        if (p->FramePeriod != 0) {
+            U64 now = Time_Now();
+
+            // NOTE(ilya.a): After a stall of more than a frame, schedule is
+            // started over, instead of rushing through missed frames.
+            if (p->Deadline == 0 || now > p->Deadline + p->FramePeriod) {
+                p->Deadline = now;
+            } else if (now < p->Deadline) {
+                _WaitUntil(p, p->Deadline);
+            }
+
+            p->Deadline += p->FramePeriod;
+        }
+
+        U64 now = Time_Now();
+        if (p->LastFrame != 0) {
+            U64 elapsed = now - p->LastFrame;
+            p->FrameTimes[p->FrameCount % BMR_PACING_SAMPLES] = elapsed;
+            p->FrameCount++;
+
+            if (p->StepPeriod != 0) {
+                U64 limit = BMR_PACING_MAX_STEPS * p->StepPeriod;
+                p->Accumulator += elapsed;
+                p->Accumulator = p->Accumulator < limit ? p->Accumulator : limit;
+            }
+        }
+
+        p->LastFrame = now;
+        p->IsStepPending = true;
+    }
+
+    bool
+    Pacing_Step(Pacer *p) noexcept
+    {
+        if (p->StepPeriod == 0) {
+            bool isPending = p->IsStepPending;
+            p->IsStepPending = false;
+            return isPending;
+        }
+
+        if (p->Accumulator < p->StepPeriod) {
+            return false;
+        }
+
+        p->Accumulator -= p->StepPeriod;
+        return true;
+    }
+
+    F32
+    Pacing_GetAlpha(const Pacer *p) noexcept
+    {
+        if (p->StepPeriod == 0) {
+            return 0.0f;
+        }
+        return (F32)((F64)p->Accumulator / (F64)p->StepPeriod);
+    }
+
+    void
+    Pacing_MarkInput(Pacer *p, U64 time) noexcept
+    {
+        if (p->PendingInput == 0 || time < p->PendingInput) {
+            p->PendingInput = time;
+        }
+    }
+
+    void
+    Pacing_MarkPresent(Pacer *p, U64 time) noexcept
+    {
+        p->LastPresent = time;
+
+        if (p->PendingInput == 0) {
+            return;
+        }
+
+        p->Latencies[p->LatencyCount % BMR_PACING_SAMPLES] = 
+            time > p->PendingInput ? time - p->PendingInput : 0;
+        p->LatencyCount++;
+        p->PendingInput = 0;
+    }
+
+    InternalFunc int
+    _CompareU64(const void *a, const void *b) noexcept
+    {
+        U64 x = *(const U64 *)a;
+        U64 y = *(const U64 *)b;
+        return (x > y) - (x < y);
+    }
+
+    /*
+     * Sorts latest samples of ring into `sorted`, returns their number.
+     */
+    InternalFunc U64
+    _SortSamples(const U64 *ring, U64 total, Out U64 *sorted) noexcept
+    {
+        U64 count = total < BMR_PACING_SAMPLES ? total : BMR_PACING_SAMPLES;
+
+        memcpy(sorted, ring, count * sizeof(U64));
+        qsort(sorted, count, sizeof(U64), _CompareU64);
+        return count;
+    }
+
+    /*
+     * Nearest rank percentile of sorted samples.
+     */
+    InternalFunc U64
+    _GetPercentile(const U64 *sorted, U64 count, U64 percent) noexcept
+    {
+        if (count == 0) {
+            return 0;
+        }
+
+        U64 rank = (percent * count + 99) / 100;
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    PacingStats
+    Pacing_GetStats(const Pacer *p) noexcept
+    {
+        PacingStats stats = {};
+        U64 sorted[BMR_PACING_SAMPLES];
+
+        stats.Frames = p->FrameCount;
+        stats.SleepTime = p->SleepTime;
+        stats.SpinTime = p->SpinTime;
+        stats.LastPresent = p->LastPresent;
+
+        U64 count = _SortSamples(p->FrameTimes, p->FrameCount, sorted);
+        stats.FrameTimeP50 = _GetPercentile(sorted, count, 50);
+        stats.FrameTimeP99 = _GetPercentile(sorted, count, 99);
+
+        stats.Inputs = p->LatencyCount;
+        if (p->LatencyCount != 0) {
+            stats.LatencyLast = p->Latencies[(p->LatencyCount - 1) % BMR_PACING_SAMPLES];
+        }
+
+        count = _SortSamples(p->Latencies, p->LatencyCount, sorted);
+        stats.LatencyP50 = _GetPercentile(sorted, count, 50);
+        stats.LatencyP90 = _GetPercentile(sorted, count, 90);
+        stats.LatencyP99 = _GetPercentile(sorted, count, 99);
+        stats.LatencyMax = count != 0 ? sorted[count - 1] : 0;
+
+        return stats;
+    }
+
+};  // namespace BMR
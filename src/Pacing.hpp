@@ -0,0 +1,80 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Pacing.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Frame pacing. Frames are started at fixed rate, by sleeping most of the
+ * wait and spinning the rest, because sleep wakes up late. Simulation
+ * steps are taken out of accumulated frame time, and time between input
+ * and the frame, which presented it, is recorded.
+ * */
+
+#ifndef SBMR_PACING_HPP_INCLUDED
+#define SBMR_PACING_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "BMR.hpp"
+
+
+#define BMR_PACING_SAMPLES   256  // NOTE(ilya.a): Latest ones are used for percentiles.
+#define BMR_PACING_MAX_STEPS 8    // NOTE(ilya.a): Per frame, the rest of time is dropped.
+
+
+namespace BMR {
+
+    struct Pacer {
+        U64 FramePeriod;  // NOTE(ilya.a): Zero, if frame rate isn't capped.
+        U64 StepPeriod;   // NOTE(ilya.a): Zero, if simulation is stepped once per frame.
+
+        U64 Deadline;     // NOTE(ilya.a): When next frame starts.
+        U64 SpinMargin;   // NOTE(ilya.a): Part of wait, which is spun instead of slept.
+        U64 LastFrame;
+        U64 Accumulator;
+        bool IsStepPending;
+
+        U64 PendingInput; // NOTE(ilya.a): Earliest input, which isn't presented yet.
+        U64 LastPresent;
+
+        U64 Latencies[BMR_PACING_SAMPLES];
+        U64 FrameTimes[BMR_PACING_SAMPLES];
+        U64 LatencyCount;
+        U64 FrameCount;
+
+        U64 SleepTime;
+        U64 SpinTime;
+    };
+
+    void Pacing_Reset(Pacer *p) noexcept;
+    void Pacing_SetFrameRate(Pacer *p, U32 fps) noexcept;
+    void Pacing_SetStepRate(Pacer *p, U32 hz) noexcept;
+
+    /*
+     * Waits until next frame should start, and adds time since previous
+     * frame to simulation.
+     */
+    void Pacing_WaitForFrame(Pacer *p) noexcept;
+
+    /*
+     * Takes one simulation step out of accumulated time, returns `false`
+     * when there's not enough time left for it.
+     */
+    bool Pacing_Step(Pacer *p) noexcept;
+
+    /*
+     * Fraction of step, which is left in accumulator.
+     */
+    F32 Pacing_GetAlpha(const Pacer *p) noexcept;
+
+    void Pacing_MarkInput(Pacer *p, U64 time) noexcept;
+    void Pacing_MarkPresent(Pacer *p, U64 time) noexcept;
+
+    PacingStats Pacing_GetStats(const Pacer *p) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_PACING_HPP_INCLUDED
@@ -0,0 +1,649 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Raster.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+#include <math.h>
+
+#include "Raster.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "Format.hpp"
+#include "Simd.hpp"
+
+
+// NOTE(ilya.a): Non-BGRA surfaces are processed in chunks, which are
+// converted to `Color4` on the stack.
+#define BMR_RASTER_SCRATCH_PIXELS 256
+
+// NOTE(ilya.a): Smaller transforms can't be inverted in 16.16 anyway.
+#define BMR_AFFINE_MIN_DET   1e-9
+#define BMR_AFFINE_MAX_COORD ((F64)((S64)1 << 40))
+#define BMR_AFFINE_MAX_FIXED ((F64)((S64)1 << 46))
+
+static_assert(BMR_AFFINE_BLOCK <= BMR_RASTER_SCRATCH_PIXELS);
+
+
+namespace BMR {
+
+    InternalFunc void
+    _FillSpan8(U8 *pixel, S64 count, U8 value) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        __m128i v = _mm_set1_epi8((char)value);
+        for (; x + 16 <= count; x += 16) {
+            _mm_storeu_si128((__m128i *)(pixel + x), v);
+        }
+#endif
+        for (; x < count; ++x) {
+            pixel[x] = value;
+        }
+    }
+
+    InternalFunc void
+    _FillSpan16(U16 *pixel, S64 count, U16 value) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        __m128i v = _mm_set1_epi16((short)value);
+        for (; x + 8 <= count; x += 8) {
+            _mm_storeu_si128((__m128i *)(pixel + x), v);
+        }
+#endif
+        for (; x < count; ++x) {
+            pixel[x] = value;
+        }
+    }
+
+    InternalFunc void
+    _FillSpan32(U32 *pixel, S64 count, U32 value) noexcept
+    {
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        __m128i v = _mm_set1_epi32((int)value);
+        for (; x + 4 <= count; x += 4) {
+            _mm_storeu_si128((__m128i *)(pixel + x), v);
+        }
+#endif
+        for (; x < count; ++x) {
+            pixel[x] = value;
+        }
+    }
+
+    /*
+     * Fills `count` pixels of row `y` with packed `value`.
+     */
+    InternalFunc void
+    _FillRow(Surface *dst, S64 x, S64 y, S64 count, U32 value) noexcept
+    {
+        U8 *pixel = GetPixelAddress(dst, x, y);
+
+        switch (dst->Format) {
+            case (PixelFormat::RGB565): {
+                _FillSpan16((U16 *)pixel, count, (U16)value);
+            } break;
+            case (PixelFormat::INDEXED8): {
+                _FillSpan8(pixel, count, (U8)value);
+            } break;
+            case (PixelFormat::BGRA8888):
+            default: {
+                _FillSpan32((U32 *)pixel, count, value);
+            } break;
+        }
+    }
+
+    void 
+    Raster_Fill(Surface *dst, const Clip &clip, 
+                const Clip &area, const Color4 &c) noexcept
+    {
+        Clip r = area.Intersect(clip);
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        U32 value = Format_Pack(dst, c);
+
+        for (S64 y = r.Y0; y < r.Y1; ++y) {
+            _FillRow(dst, r.X0, y, r.X1 - r.X0, value);
+        }
+    }
+
+    InternalFunc void
+    _GradientSpan(U32 *pixel, S64 x, S64 count, 
+                  U32 xOffset, U32 green) noexcept
+    {
+        S64 i = 0;
+#if BMR_SIMD_SSE2
+        __m128i red = _mm_setr_epi32(
+            (int)(x + xOffset + 0), (int)(x + xOffset + 1), 
+            (int)(x + xOffset + 2), (int)(x + xOffset + 3));
+        const __m128i step = _mm_set1_epi32(4);
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        const __m128i g = _mm_set1_epi32((int)green);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(red, mask), 16), g);
+            _mm_storeu_si128((__m128i *)(pixel + i), v);
+            red = _mm_add_epi32(red, step);
+        }
+#endif
+        for (; i < count; ++i) {
+            pixel[i] = (((U32)(x + i + xOffset) & 0xFF) << 16) | green;
+        }
+    }
+
+    void 
+    Raster_Gradient(Surface *dst, const Clip &clip, 
+                    U32 xOffset, U32 yOffset) noexcept
+    {
+        Clip r = clip.Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        // NOTE(ilya.a): Red is growing along X, green along Y. Both are
+        // wrapping around, because they are truncated to `U8`.
+        for (S64 y = r.Y0; y < r.Y1; ++y) {
+            U32 green = ((U32)(y + yOffset) & 0xFF) << 8;
+
+            if (dst->Format == PixelFormat::BGRA8888) {
+                _GradientSpan((U32 *)GetPixelAddress(dst, r.X0, y), r.X0, r.X1 - r.X0, xOffset, green);
+                continue;
+            }
+
+            Color4 scratch[BMR_RASTER_SCRATCH_PIXELS];
+            for (S64 x = r.X0; x < r.X1; x += BMR_RASTER_SCRATCH_PIXELS) {
+                S64 count = r.X1 - x < BMR_RASTER_SCRATCH_PIXELS ? r.X1 - x : BMR_RASTER_SCRATCH_PIXELS;
+                _GradientSpan((U32 *)scratch, x, count, xOffset, green);
+                Format_StoreSpan(dst, x, y, scratch, count);
+            }
+        }
+    }
+
+    InternalFunc inline U8
+    _Lerp8(U8 d, U8 s, U8 a) noexcept
+    {
+        U32 v = Mul8(s, a) + Mul8(d, MAX_U8 - a);
+        return (U8)(v > MAX_U8 ? MAX_U8 : v);
+    }
+
+    InternalFunc inline U8
+    _Add8(U8 d, U8 s, U8 a) noexcept
+    {
+        U32 v = d + Mul8(s, a);
+        return (U8)(v > MAX_U8 ? MAX_U8 : v);
+    }
+
+    InternalFunc inline U8
+    _Multiply8(U8 d, U8 s, U8 a) noexcept
+    {
+        return Mul8(d, Mul8(s, a) + (MAX_U8 - a));
+    }
+
+    InternalFunc Color4
+    _BlendPixel(Color4 d, Color4 s, U8 opacity, BlendMode mode) noexcept
+    {
+        switch (mode) {
+            case (BlendMode::ALPHA): {
+                U8 a = Mul8(s.A, opacity);
+                return Color4(_Lerp8(d.R, s.R, a), _Lerp8(d.G, s.G, a), 
+                              _Lerp8(d.B, s.B, a), _Lerp8(d.A, s.A, a));
+            } break;
+            case (BlendMode::ADD): {
+                return Color4(_Add8(d.R, s.R, opacity), _Add8(d.G, s.G, opacity), 
+                              _Add8(d.B, s.B, opacity), _Add8(d.A, s.A, opacity));
+            } break;
+            case (BlendMode::MULTIPLY): {
+                return Color4(_Multiply8(d.R, s.R, opacity), _Multiply8(d.G, s.G, opacity), 
+                              _Multiply8(d.B, s.B, opacity), _Multiply8(d.A, s.A, opacity));
+            } break;
+            case (BlendMode::NORMAL):
+            default: {
+                return Color4(_Lerp8(d.R, s.R, opacity), _Lerp8(d.G, s.G, opacity), 
+                              _Lerp8(d.B, s.B, opacity), _Lerp8(d.A, s.A, opacity));
+            } break;
+        }
+    }
+
+#if BMR_SIMD_SSE2
+    /*
+     * Blends two pixels, which are unpacked into 16-bit lanes.
+     */
+    InternalFunc inline __m128i
+    _BlendUnpacked(__m128i d, __m128i s, __m128i opacity, BlendMode mode) noexcept
+    {
+        const __m128i max = _mm_set1_epi16(MAX_U8);
+
+        switch (mode) {
+            case (BlendMode::ALPHA): {
+                __m128i a = Simd_Mul8(Simd_BroadcastAlpha(s), opacity);
+                return _mm_add_epi16(Simd_Mul8(s, a), Simd_Mul8(d, _mm_sub_epi16(max, a)));
+            } break;
+            case (BlendMode::ADD): {
+                return _mm_add_epi16(d, Simd_Mul8(s, opacity));
+            } break;
+            case (BlendMode::MULTIPLY): {
+                __m128i factor = _mm_add_epi16(Simd_Mul8(s, opacity), _mm_sub_epi16(max, opacity));
+                return Simd_Mul8(d, factor);
+            } break;
+            case (BlendMode::NORMAL):
+            default: {
+                return _mm_add_epi16(Simd_Mul8(s, opacity), Simd_Mul8(d, _mm_sub_epi16(max, opacity)));
+            } break;
+        }
+    }
+#endif
+
+    InternalFunc void
+    _CompositeSpan(Color4 *d, const Color4 *s, S64 count, 
+                   U8 opacity, BlendMode mode) noexcept
+    {
+        // NOTE(ilya.a): Opaque copy, e.g. when canvas is presented.
+        if (mode == BlendMode::NORMAL && opacity == MAX_U8) {
+            memcpy(d, s, (Size)count * sizeof(Color4));
+            return;
+        }
+
+        S64 x = 0;
+#if BMR_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i a = _mm_set1_epi16(opacity);
+
+        for (; x + 4 <= count; x += 4) {
+            __m128i dv = _mm_loadu_si128((const __m128i *)(d + x));
+            __m128i sv = _mm_loadu_si128((const __m128i *)(s + x));
+
+            // NOTE(ilya.a): Results are saturated by `packus`, same as scalar
+            // path is clamping them.
+            __m128i lo = _BlendUnpacked(
+                _mm_unpacklo_epi8(dv, zero), _mm_unpacklo_epi8(sv, zero), a, mode);
+            __m128i hi = _BlendUnpacked(
+                _mm_unpackhi_epi8(dv, zero), _mm_unpackhi_epi8(sv, zero), a, mode);
+
+            _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x < count; ++x) {
+            d[x] = _BlendPixel(d[x], s[x], opacity, mode);
+        }
+    }
+
+    void 
+    Raster_Composite(Surface *dst, const Clip &clip, 
+                     const Surface *src, S64 x, S64 y, 
+                     U8 opacity, BlendMode mode) noexcept
+    {
+        if (src == nullptr || src->Buffer == nullptr) {
+            return;
+        }
+
+        Clip area = Clip{x, y, x + (S64)src->Width, y + (S64)src->Height};
+        Clip r = area.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        bool isDirect = dst->Format == PixelFormat::BGRA8888 
+                     && src->Format == PixelFormat::BGRA8888;
+
+        for (S64 row = r.Y0; row < r.Y1; ++row) {
+            if (isDirect) {
+                Color4 *d = (Color4 *)GetPixelAddress(dst, r.X0, row);
+                const Color4 *s = (const Color4 *)GetPixelAddress(src, r.X0 - x + src->X, row - y + src->Y);
+                _CompositeSpan(d, s, r.X1 - r.X0, opacity, mode);
+                continue;
+            }
+
+            Color4 d[BMR_RASTER_SCRATCH_PIXELS];
+            Color4 s[BMR_RASTER_SCRATCH_PIXELS];
+
+            for (S64 col = r.X0; col < r.X1; col += BMR_RASTER_SCRATCH_PIXELS) {
+                S64 count = r.X1 - col < BMR_RASTER_SCRATCH_PIXELS ? r.X1 - col : BMR_RASTER_SCRATCH_PIXELS;
+
+                Format_LoadSpan(dst, col, row, d, count);
+                Format_LoadSpan(src, col - x + src->X, row - y + src->Y, s, count);
+                _CompositeSpan(d, s, count, opacity, mode);
+                Format_StoreSpan(dst, col, row, d, count);
+            }
+        }
+    }
+
+    void 
+    Raster_Magnify(Surface *dst, const Clip &clip, 
+                   const Surface *src, S64 x, S64 y, U32 scale, 
+                   U8 opacity, BlendMode mode) noexcept
+    {
+        if (src == nullptr || src->Buffer == nullptr || scale == 0) {
+            return;
+        }
+
+        Clip area = Clip{
+            x * scale, y * scale, 
+            (x + (S64)src->Width) * scale, (y + (S64)src->Height) * scale,
+        };
+        Clip r = area.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        Color4 d[BMR_RASTER_SCRATCH_PIXELS];
+        Color4 s[BMR_RASTER_SCRATCH_PIXELS];
+        Color4 texels[BMR_RASTER_SCRATCH_PIXELS + 1];
+
+        for (S64 row = r.Y0; row < r.Y1; ++row) {
+            S64 ty = (row - area.Y0) / scale + src->Y;
+
+            for (S64 col = r.X0; col < r.X1; col += BMR_RASTER_SCRATCH_PIXELS) {
+                S64 count = r.X1 - col < BMR_RASTER_SCRATCH_PIXELS ? r.X1 - col : BMR_RASTER_SCRATCH_PIXELS;
+                S64 first = (col - area.X0) / scale;
+                S64 last = (col + count - 1 - area.X0) / scale;
+
+                Format_LoadSpan(src, first + src->X, ty, texels, last - first + 1);
+
+                // NOTE(ilya.a): Span may start in the middle of texel.
+                S64 phase = (col - area.X0) % scale;
+                S64 texel = 0;
+                for (S64 i = 0; i < count; ++i) {
+                    s[i] = texels[texel];
+                    if (++phase == scale) {
+                        phase = 0;
+                        ++texel;
+                    }
+                }
+
+                if (dst->Format == PixelFormat::BGRA8888) {
+                    _CompositeSpan((Color4 *)GetPixelAddress(dst, col, row), s, count, opacity, mode);
+                    continue;
+                }
+
+                Format_LoadSpan(dst, col, row, d, count);
+                _CompositeSpan(d, s, count, opacity, mode);
+                Format_StoreSpan(dst, col, row, d, count);
+            }
+        }
+    }
+
+    InternalFunc inline S64
+    _ClampFixed(F64 value) noexcept
+    {
+        value = value < BMR_AFFINE_MAX_FIXED ? value : BMR_AFFINE_MAX_FIXED;
+        value = value > -BMR_AFFINE_MAX_FIXED ? value : -BMR_AFFINE_MAX_FIXED;
+        return ToFixed(value);
+    }
+
+    InternalFunc inline S64
+    _FloorDiv(S64 a, S64 b) noexcept
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    AffineMap
+    Raster_GetAffineMap(const Transform &t, const Rect &r) noexcept
+    {
+        AffineMap m = {};
+
+        F64 a = (F64)t.A / BMR_FIXED_ONE, b = (F64)t.B / BMR_FIXED_ONE;
+        F64 c = (F64)t.C / BMR_FIXED_ONE, d = (F64)t.D / BMR_FIXED_ONE;
+        F64 tx = (F64)t.X / BMR_FIXED_ONE, ty = (F64)t.Y / BMR_FIXED_ONE;
+        F64 det = a * d - b * c;
+
+        if (r.Width == 0 || r.Height == 0 || fabs(det) < BMR_AFFINE_MIN_DET) {
+            return m;
+        }
+
+        F64 x0 = r.X, y0 = r.Y;
+        F64 x1 = x0 + r.Width, y1 = y0 + r.Height;
+        F64 xs[4] = { a * x0 + b * y0, a * x1 + b * y0, a * x0 + b * y1, a * x1 + b * y1 };
+        F64 ys[4] = { c * x0 + d * y0, c * x1 + d * y0, c * x0 + d * y1, c * x1 + d * y1 };
+
+        F64 minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+        for (U32 i = 1; i < 4; ++i) {
+            minX = xs[i] < minX ? xs[i] : minX;
+            maxX = xs[i] > maxX ? xs[i] : maxX;
+            minY = ys[i] < minY ? ys[i] : minY;
+            maxY = ys[i] > maxY ? ys[i] : maxY;
+        }
+
+        // NOTE(ilya.a): Pixel of margin on each side covers rounding of
+        // fixed point steps.
+        const F64 limit = BMR_AFFINE_MAX_COORD;
+        m.Bounds = Clip{
+            (S64)floor(fmax(minX + tx, -limit)) - 1, (S64)floor(fmax(minY + ty, -limit)) - 1,
+            (S64)ceil(fmin(maxX + tx, limit)) + 1,   (S64)ceil(fmin(maxY + ty, limit)) + 1,
+        };
+
+        m.Width = (S64)r.Width << BMR_FIXED_SHIFT;
+        m.Height = (S64)r.Height << BMR_FIXED_SHIFT;
+
+        m.Ux = d / det;
+        m.Uy = -b / det;
+        m.Vx = -c / det;
+        m.Vy = a / det;
+        m.U0 = -(m.Ux * tx + m.Uy * ty) - x0;
+        m.V0 = -(m.Vx * tx + m.Vy * ty) - y0;
+
+        m.DuDx = _ClampFixed(m.Ux);
+        m.DvDx = _ClampFixed(m.Vx);
+        return m;
+    }
+
+    void
+    Raster_MapBlock(const AffineMap &m, S64 x, S64 y, 
+                    Out S64 *blockX, Out S64 *u, Out S64 *v) noexcept
+    {
+        *blockX = _FloorDiv(x, BMR_AFFINE_BLOCK) * BMR_AFFINE_BLOCK;
+
+        F64 px = (F64)*blockX + 0.5;
+        F64 py = (F64)y + 0.5;
+        *u = _ClampFixed(m.Ux * px + m.Uy * py + m.U0);
+        *v = _ClampFixed(m.Vx * px + m.Vy * py + m.V0);
+    }
+
+    /*
+     * Narrows `[*k0; *k1)` to steps, for which `0 <= a + k * d < limit`.
+     * It's where edge functions of two opposite edges are both positive.
+     */
+    InternalFunc void
+    _NarrowSpan(S64 a, S64 d, S64 limit, Out S64 *k0, Out S64 *k1) noexcept
+    {
+        S64 lo, hi;
+
+        if (d == 0) {
+            if (a < 0 || a >= limit) {
+                *k1 = *k0;
+            }
+            return;
+        }
+
+        if (d > 0) {
+            lo = -_FloorDiv(a, d);
+            hi = _FloorDiv(limit - 1 - a, d) + 1;
+        } else {
+            lo = _FloorDiv(a - limit, -d) + 1;
+            hi = _FloorDiv(a, -d) + 1;
+        }
+
+        *k0 = lo > *k0 ? lo : *k0;
+        *k1 = hi < *k1 ? hi : *k1;
+    }
+
+    /*
+     * Covered part of row `y`, which starts at `*x` and lies inside of one
+     * block and `r`. `*x` is moved to the next block. Returns `false`, if
+     * nothing is covered.
+     */
+    InternalFunc bool
+    _GetAffineSpan(const AffineMap &m, const Clip &r, Out S64 *x, S64 y,
+                   Out S64 *spanX, Out S64 *count, Out S64 *u, Out S64 *v) noexcept
+    {
+        S64 blockX, bu, bv;
+        Raster_MapBlock(m, *x, y, &blockX, &bu, &bv);
+
+        S64 end = blockX + BMR_AFFINE_BLOCK < r.X1 ? blockX + BMR_AFFINE_BLOCK : r.X1;
+        S64 k0 = *x - blockX;
+        S64 k1 = end - blockX;
+        *x = end;
+
+        _NarrowSpan(bu, m.DuDx, m.Width, &k0, &k1);
+        _NarrowSpan(bv, m.DvDx, m.Height, &k0, &k1);
+        if (k0 >= k1) {
+            return false;
+        }
+
+        *spanX = blockX + k0;
+        *count = k1 - k0;
+        *u = bu + k0 * m.DuDx;
+        *v = bv + k0 * m.DvDx;
+        return true;
+    }
+
+    void 
+    Raster_Quad(Surface *dst, const Clip &clip, 
+                const AffineMap &m, const Color4 &c) noexcept
+    {
+        Clip r = m.Bounds.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        U32 value = Format_Pack(dst, c);
+
+        for (S64 y = r.Y0; y < r.Y1; ++y) {
+            for (S64 x = r.X0; x < r.X1;) {
+                S64 spanX, count, u, v;
+                if (_GetAffineSpan(m, r, &x, y, &spanX, &count, &u, &v)) {
+                    _FillRow(dst, spanX, y, count, value);
+                }
+            }
+        }
+    }
+
+    InternalFunc inline Color4
+    _LoadTexel(const Surface *src, S64 x, S64 y) noexcept
+    {
+        Color4 texel;
+        if (src->Format == PixelFormat::BGRA8888) {
+            memcpy(&texel, GetPixelAddress(src, src->X + x, src->Y + y), sizeof(texel));
+        } else {
+            Format_LoadSpan(src, src->X + x, src->Y + y, &texel, 1);
+        }
+        return texel;
+    }
+
+    /*
+     * Samples `count` pixels of source bilinearly, starting at mapped point
+     * `u`, `v`. Texels outside of source are clamped to its edges.
+     */
+    InternalFunc void
+    _SampleSpan(const Surface *src, S64 u, S64 v, S64 du, S64 dv, 
+                S64 count, Out Color4 *out) noexcept
+    {
+        const S64 half = BMR_FIXED_ONE / 2;
+        const S64 w = (S64)src->Width - 1;
+        const S64 h = (S64)src->Height - 1;
+
+#if BMR_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(256);
+#endif
+
+        for (S64 i = 0; i < count; ++i, u += du, v += dv) {
+            // NOTE(ilya.a): Relative to centers of texels.
+            S64 su = u - half;
+            S64 sv = v - half;
+            S64 tx = su >> BMR_FIXED_SHIFT;
+            S64 ty = sv >> BMR_FIXED_SHIFT;
+            U32 fx = (U32)(su >> 8) & 0xFF;
+            U32 fy = (U32)(sv >> 8) & 0xFF;
+
+            S64 x0 = tx < 0 ? 0 : (tx > w ? w : tx);
+            S64 x1 = tx + 1 < 0 ? 0 : (tx + 1 > w ? w : tx + 1);
+            S64 y0 = ty < 0 ? 0 : (ty > h ? h : ty);
+            S64 y1 = ty + 1 < 0 ? 0 : (ty + 1 > h ? h : ty + 1);
+
+            Color4 t00 = _LoadTexel(src, x0, y0), t10 = _LoadTexel(src, x1, y0);
+            Color4 t01 = _LoadTexel(src, x0, y1), t11 = _LoadTexel(src, x1, y1);
+
+#if BMR_SIMD_SSE2
+            S32 p00, p10, p01, p11;
+            memcpy(&p00, &t00, 4); memcpy(&p10, &t10, 4);
+            memcpy(&p01, &t01, 4); memcpy(&p11, &t11, 4);
+
+            // NOTE(ilya.a): Left and right texels are in low and high half.
+            // Weights sum to 256, so lanes never overflow 16 bits.
+            __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(p00), _mm_cvtsi32_si128(p10)), zero);
+            __m128i bot = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(p01), _mm_cvtsi32_si128(p11)), zero);
+
+            __m128i wy = _mm_set1_epi16((short)fy);
+            __m128i col = _mm_srli_epi16(_mm_add_epi16(
+                _mm_mullo_epi16(top, _mm_sub_epi16(full, wy)), _mm_mullo_epi16(bot, wy)), 8);
+
+            __m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - fx)), _mm_set1_epi16((short)fx));
+            __m128i row = _mm_mullo_epi16(col, wx);
+            row = _mm_srli_epi16(_mm_add_epi16(row, _mm_srli_si128(row, 8)), 8);
+
+            S32 packed = _mm_cvtsi128_si32(_mm_packus_epi16(row, row));
+            memcpy((void *)(out + i), &packed, sizeof(packed));
+#else
+            const U8 *a = (const U8 *)&t00, *b = (const U8 *)&t10;
+            const U8 *c = (const U8 *)&t01, *d = (const U8 *)&t11;
+            U8 *o = (U8 *)(out + i);
+
+            for (U32 lane = 0; lane < 4; ++lane) {
+                U32 left = (a[lane] * (256 - fy) + c[lane] * fy) >> 8;
+                U32 right = (b[lane] * (256 - fy) + d[lane] * fy) >> 8;
+                o[lane] = (U8)((left * (256 - fx) + right * fx) >> 8);
+            }
+#endif
+        }
+    }
+
+    void 
+    Raster_Sprite(Surface *dst, const Clip &clip, 
+                  const AffineMap &m, const Surface *src, 
+                  U8 opacity, BlendMode mode) noexcept
+    {
+        if (src == nullptr || src->Buffer == nullptr || src->Width == 0 || src->Height == 0) {
+            return;
+        }
+
+        Clip r = m.Bounds.Intersect(clip).Intersect(Raster_GetSurfaceClip(dst));
+        if (r.IsEmpty()) {
+            return;
+        }
+
+        Color4 s[BMR_RASTER_SCRATCH_PIXELS];
+        Color4 d[BMR_RASTER_SCRATCH_PIXELS];
+
+        for (S64 y = r.Y0; y < r.Y1; ++y) {
+            for (S64 x = r.X0; x < r.X1;) {
+                S64 spanX, count, u, v;
+                if (!_GetAffineSpan(m, r, &x, y, &spanX, &count, &u, &v)) {
+                    continue;
+                }
+
+                _SampleSpan(src, u, v, m.DuDx, m.DvDx, count, s);
+
+                if (dst->Format == PixelFormat::BGRA8888) {
+                    _CompositeSpan((Color4 *)GetPixelAddress(dst, spanX, y), s, count, opacity, mode);
+                    continue;
+                }
+
+                Format_LoadSpan(dst, spanX, y, d, count);
+                _CompositeSpan(d, s, count, opacity, mode);
+                Format_StoreSpan(dst, spanX, y, d, count);
+            }
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,161 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Raster.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Span kernels, which are used by `BMR::EndDrawing` to execute render
+ * commands. Each kernel touches only pixels covered by the command and
+ * lying inside of clip rectangle.
+ * */
+
+#ifndef SBMR_RASTER_HPP_INCLUDED
+#define SBMR_RASTER_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+#include "Lin.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+
+
+/*
+ * Half-open rectangle `[X0; X1) x [Y0; Y1)` in surface coordinates.
+ */
+struct Clip {
+    S64 X0;
+    S64 Y0;
+    S64 X1;
+    S64 Y1;
+
+    constexpr bool IsEmpty() const noexcept
+    {
+        return X0 >= X1 || Y0 >= Y1;
+    }
+
+    constexpr Clip Intersect(const Clip &c) const noexcept
+    {
+        return Clip{
+            X0 > c.X0 ? X0 : c.X0,
+            Y0 > c.Y0 ? Y0 : c.Y0,
+            X1 < c.X1 ? X1 : c.X1,
+            Y1 < c.Y1 ? Y1 : c.Y1,
+        };
+    }
+};
+
+
+// NOTE(ilya.a): Inverse mapping of transformed rect is evaluated exactly
+// at the first pixel of each block of row, and stepped in fixed point
+// inside of it, so rounding error doesn't grow along long rows.
+#define BMR_AFFINE_BLOCK 256
+
+
+/*
+ * Rect, which is mapped by transform onto pixels of surface.
+ *
+ * Pixel is covered, when its center is mapped inside of the rect, so
+ * adjacent rects never cover the same pixel twice. Mapped point is
+ * `(U; V)` in 16.16 fixed point, relative to top left corner of rect.
+ */
+struct AffineMap {
+    Clip Bounds;  // NOTE(ilya.a): Conservative, empty for degenerate transform.
+    S64  Width;   // NOTE(ilya.a): Of rect, in 16.16.
+    S64  Height;
+
+    // NOTE(ilya.a): Inverse transform, rect's top left corner is origin.
+    F64 Ux, Uy, Vx, Vy, U0, V0;
+
+    S64 DuDx;  // NOTE(ilya.a): Step of mapped point along row, in 16.16.
+    S64 DvDx;
+};
+
+
+namespace BMR {
+
+    constexpr Clip
+    Raster_GetSurfaceClip(const Surface *s) noexcept
+    {
+        return Clip{s->X, s->Y, s->X + (S64)s->Width, s->Y + (S64)s->Height};
+    }
+
+    constexpr Clip
+    Raster_GetRectClip(const Rect &r) noexcept
+    {
+        return Clip{r.X, r.Y, (S64)r.X + r.Width, (S64)r.Y + r.Height};
+    }
+
+    void Raster_Fill(Surface *dst, const Clip &clip, 
+                     const Clip &area, const Color4 &c) noexcept;
+
+    void Raster_Gradient(Surface *dst, const Clip &clip, 
+                         U32 xOffset, U32 yOffset) noexcept;
+
+    void Raster_GradientEx(Surface *dst, const Clip &clip, 
+                           const Clip &area, const Gradient &g) noexcept;
+
+    void Raster_Line(Surface *dst, const Clip &clip, 
+                     Vec2u p1, Vec2u p2, 
+                     const Color4 &c, LineMode mode) noexcept;
+
+    void Raster_Composite(Surface *dst, const Clip &clip, 
+                          const Surface *src, S64 x, S64 y, 
+                          U8 opacity, BlendMode mode) noexcept;
+
+    /*
+     * Same as `Raster_Composite`, but each pixel of `src` covers `scale`
+     * by `scale` pixels of `dst`, and `x`, `y` are multiplied by it.
+     */
+    void Raster_Magnify(Surface *dst, const Clip &clip, 
+                        const Surface *src, S64 x, S64 y, U32 scale, 
+                        U8 opacity, BlendMode mode) noexcept;
+
+    AffineMap Raster_GetAffineMap(const Transform &t, const Rect &r) noexcept;
+
+    /*
+     * Mapped point of the first pixel of block, which contains pixel `x`
+     * of row `y`. Points of next pixels are `DuDx`, `DvDx` apart.
+     */
+    void Raster_MapBlock(const AffineMap &m, S64 x, S64 y, 
+                         Out S64 *blockX, Out S64 *u, Out S64 *v) noexcept;
+
+    /*
+     * Rotated, sheared or scaled rect, mapped by `m`, is filled by spans, 
+     * which are found from its edges row by row. Sprite samples `src`
+     * bilinearly, from four texels around mapped point of each pixel.
+     */
+    void Raster_Quad(Surface *dst, const Clip &clip, 
+                     const AffineMap &m, const Color4 &c) noexcept;
+    void Raster_Sprite(Surface *dst, const Clip &clip, 
+                       const AffineMap &m, const Surface *src, 
+                       U8 opacity, BlendMode mode) noexcept;
+
+    /*
+     * Post-processing of pixels inside of `area`, which are already drawn.
+     * Pixels outside of it are not read. Only `BGRA8888` is supported.
+     * Passes are split between worker threads.
+     */
+    void Raster_Blur(Surface *dst, const Clip &clip, const Clip &area, 
+                     U32 radius, BlurKind kind) noexcept;
+    void Raster_Downsample(Surface *dst, const Clip &clip, const Clip &area) noexcept;
+
+    /*
+     * Averages each `scale` by `scale` block of `BGRA8888` samples into
+     * pixel of `dst`, for pixels inside of `clip`. Pixel `x`, `y` is
+     * resolved from the block, which starts at sample `x * scale`,
+     * `y * scale`. Scale is 2 or 4.
+     */
+    void Raster_Resolve(Surface *dst, const Clip &clip, 
+                        const Surface *samples, U32 scale) noexcept;
+
+    /*
+     * Releases memory, which post-processing kept between commands.
+     */
+    void Raster_ReleaseScratch() noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_RASTER_HPP_INCLUDED
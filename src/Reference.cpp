@@ -0,0 +1,276 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Reference.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include "Reference.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Lin.hpp"
+#include "Geom.hpp"
+#include "Surface.hpp"
+#include "Gamma.hpp"
+#include "Command.hpp"
+
+
+// NOTE(ilya.a): Optimized rasterizer steps mapped point in 16.16 along at
+// most `BMR_AFFINE_BLOCK` pixels, each step rounded by at most half of
+// unit. Mapped point of pixel, which is closer to edge of rect than that,
+// may be rounded to either side of it.
+#define BMR_REFERENCE_QUAD_TOLERANCE ((F64)BMR_AFFINE_BLOCK / BMR_FIXED_ONE)
+
+
+namespace BMR {
+
+    /*
+     * Line in its own frame, where X is major axis and it goes from left
+     * to right.
+     */
+    struct _ReferenceLine {
+        bool IsSteep;
+        S64 X0;
+        S64 Y0;
+        S64 X1;
+        U64 MajorDelta;
+        U64 MinorDelta;
+        S64 MinorStep;
+    };
+
+    InternalFunc _ReferenceLine
+    _GetReferenceLine(Vec2u p1, Vec2u p2) noexcept
+    {
+        _ReferenceLine l = {};
+
+        S64 dx = (S64)p2.X - (S64)p1.X;
+        S64 dy = (S64)p2.Y - (S64)p1.Y;
+        l.IsSteep = (dx < 0 ? -dx : dx) < (dy < 0 ? -dy : dy);
+
+        S64 x0 = p1.X, y0 = p1.Y, x1 = p2.X, y1 = p2.Y;
+        if (l.IsSteep) {
+            S64 t;
+            t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+        }
+        if (x0 > x1) {
+            S64 t;
+            t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        l.X0 = x0;
+        l.Y0 = y0;
+        l.X1 = x1;
+        l.MajorDelta = (U64)(x1 - x0);
+        l.MinorDelta = (U64)(y1 > y0 ? y1 - y0 : y0 - y1);
+        l.MinorStep = y1 >= y0 ? 1 : -1;
+        return l;
+    }
+
+    /*
+     * Color of pixel after line is drawn over it.
+     *
+     * Aliased line covers one pixel per major step `k`, minor offset of
+     * which is `k * minorDelta / majorDelta` rounded to nearest, halves up.
+     * Antialiased line covers two pixels around exact minor offset, which
+     * are blended by `255 * fraction` truncated.
+     */
+    InternalFunc Color4
+    _ReferenceLinePixel(const _DrawLine_Payload &p, S64 x, S64 y, Color4 pixel) noexcept
+    {
+        _ReferenceLine l = _GetReferenceLine(p.p1, p.p2);
+
+        S64 major = l.IsSteep ? y : x;
+        S64 minor = l.IsSteep ? x : y;
+
+        if (major < l.X0 || major > l.X1) {
+            return pixel;
+        }
+
+        U64 k = (U64)(major - l.X0);
+        S64 offset = (minor - l.Y0) * l.MinorStep;
+        if (offset < 0) {
+            return pixel;
+        }
+
+        if (p.Mode == LineMode::ANTIALIASED && l.MajorDelta != 0) {
+            U64 q = (k * l.MinorDelta) / l.MajorDelta;
+            U64 rem = (k * l.MinorDelta) % l.MajorDelta;
+            U8 coverage = (U8)((MAX_U8 * rem) / l.MajorDelta);
+
+            if ((U64)offset == q) {
+                return Gamma_Blend(pixel, p.Color, MAX_U8 - coverage);
+            }
+            if ((U64)offset == q + 1 && coverage != 0) {
+                return Gamma_Blend(pixel, p.Color, coverage);
+            }
+            return pixel;
+        }
+
+        U64 q = 0;
+        if (l.MajorDelta != 0) {
+            q = (2 * k * l.MinorDelta + l.MajorDelta) / (2 * l.MajorDelta);
+        }
+
+        return (U64)offset == q ? p.Color : pixel;
+    }
+
+    enum class _Coverage {
+        OUTSIDE,
+        INSIDE,
+        EDGE,  // NOTE(ilya.a): Within rounding of optimized rasterizer.
+    };
+
+    /*
+     * Pixel is covered, if its center is mapped inside of rect. Center is
+     * mapped back by inverse of transform, solved by Cramer's rule in
+     * units of 16.16, which is exact in `F64` for coordinates of surfaces.
+     */
+    InternalFunc _Coverage
+    _ReferenceQuadPixel(const _DrawQuad_Payload &p, S64 x, S64 y) noexcept
+    {
+        const Transform &t = p.Transform;
+        F64 det = (F64)t.A * t.D - (F64)t.B * t.C;
+        if (det == 0.0) {
+            return _Coverage::OUTSIDE;
+        }
+
+        F64 px = ((F64)x + 0.5) * BMR_FIXED_ONE - (F64)t.X;
+        F64 py = ((F64)y + 0.5) * BMR_FIXED_ONE - (F64)t.Y;
+        F64 u = ((F64)t.D * px - (F64)t.B * py) / det - p.Rect.X;
+        F64 v = ((F64)t.A * py - (F64)t.C * px) / det - p.Rect.Y;
+
+        const F64 e = BMR_REFERENCE_QUAD_TOLERANCE;
+        F64 w = p.Rect.Width, h = p.Rect.Height;
+
+        if (u < -e || u >= w + e || v < -e || v >= h + e) {
+            return _Coverage::OUTSIDE;
+        }
+        if (u >= e && u < w - e && v >= e && v < h - e) {
+            return _Coverage::INSIDE;
+        }
+        return _Coverage::EDGE;
+    }
+
+    InternalFunc bool
+    _IsSupported(const U8 *begin, const U8 *end, U64 count) noexcept
+    {
+        const U8 *cursor = begin;
+
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            if ((Size)(end - cursor) < sizeof(RenderCommandType)) {
+                return false;
+            }
+
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            switch (type) {
+                case (RenderCommandType::NOP):
+                case (RenderCommandType::CLEAR):
+                case (RenderCommandType::RECT):
+                case (RenderCommandType::QUAD):
+                case (RenderCommandType::GRADIENT):
+                case (RenderCommandType::LINE): {
+                } break;
+                default: {
+                    return false;
+                } break;
+            }
+
+            Size size = Command_GetSize(type);
+            if ((Size)(end - cursor) < size) {
+                return false;
+            }
+            cursor += size;
+        }
+
+        return true;
+    }
+
+    bool 
+    Reference_Rasterize(Surface *dst, 
+                        const void *commands, Size size, U64 count,
+                        Out U8 *ambiguous) noexcept
+    {
+        const U8 *begin = (const U8 *)commands;
+
+        if (dst->Format != PixelFormat::BGRA8888 || !_IsSupported(begin, begin + size, count)) {
+            return false;
+        }
+
+        U8 *row = (U8 *)dst->Buffer;
+
+        for (U64 y = 0; y < dst->Height; ++y) {
+            Color4 *pixel = (Color4 *)row;
+
+            for (U64 x = 0; x < dst->Width; ++x) {
+                const U8 *cursor = begin;
+                bool isAmbiguous = false;
+
+                for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+                    RenderCommandType type = *((const RenderCommandType *)cursor);
+
+                    switch (type) {
+                        case (RenderCommandType::CLEAR): {
+                            auto *command = (const RenderCommand<Color4> *)cursor;
+                            *pixel = command->Payload;
+                            isAmbiguous = false;
+                        } break;
+                        case (RenderCommandType::LINE): {
+                            // NOTE(ilya.a): Line may be blended with ambiguous
+                            // pixel, so it stays ambiguous either way.
+                            auto *command = (const RenderCommand<_DrawLine_Payload> *)cursor;
+                            *pixel = _ReferenceLinePixel(command->Payload, (S64)x, (S64)y, *pixel);
+                        } break;
+                        case (RenderCommandType::RECT): {
+                            auto *command = (const RenderCommand<_DrawRect_Payload> *)cursor;
+                            const Rect &rect = command->Payload.Rect;
+
+                            if (x >= rect.X && x < (U64)rect.X + rect.Width
+                                && y >= rect.Y && y < (U64)rect.Y + rect.Height) {
+                                *pixel = command->Payload.Color;
+                                isAmbiguous = false;
+                            }
+                        } break;
+                        case (RenderCommandType::QUAD): {
+                            auto *command = (const RenderCommand<_DrawQuad_Payload> *)cursor;
+                            const _DrawQuad_Payload &p = command->Payload;
+
+                            _Coverage coverage = _ReferenceQuadPixel(p, (S64)x, (S64)y);
+                            if (coverage != _Coverage::OUTSIDE) {
+                                *pixel = p.Color;
+                                isAmbiguous = coverage == _Coverage::EDGE;
+                            }
+                        } break;
+                        case (RenderCommandType::GRADIENT): {
+                            auto *command = (const RenderCommand<Vec2u> *)cursor;
+                            const Vec2u &v = command->Payload;
+
+                            *pixel = Color4((U8)(x + v.X), (U8)(y + v.Y), 0);
+                            isAmbiguous = false;
+                        } break;
+                        default: {
+                        } break;
+                    };
+
+                    cursor += Command_GetSize(type);
+                }
+
+                if (ambiguous != nullptr) {
+                    ambiguous[y * dst->Width + x] = isAmbiguous;
+                }
+                ++pixel;
+            }
+
+            row += dst->Pitch;
+        }
+
+        return true;
+    }
+
+};  // namespace BMR
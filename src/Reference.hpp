@@ -0,0 +1,43 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Reference.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Reference renderer. It's the very first renderer of the project, which
+ * evaluates every command for every pixel. It's slow, but every pixel is
+ * computed straight from the definition of command, so it's used to check
+ * optimized rasterizer (`Fuzz.cpp`).
+ * */
+
+#ifndef SBMR_REFERENCE_HPP_INCLUDED
+#define SBMR_REFERENCE_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+
+
+namespace BMR {
+
+    /*
+     * Executes serialized commands (see `BMR::GetCommands`). Only `CLEAR`,
+     * `NOP`, `RECT`, `QUAD`, `GRADIENT` and `LINE` are supported, and only
+     * `BGRA8888` surfaces. Returns `false` and leaves surface untouched
+     * otherwise.
+     *
+     * Quad coverage is computed independently of optimized rasterizer, so
+     * pixels, which centers are mapped within its rounding of an edge, may
+     * differ. They are set to one in `ambiguous`, if it's given, which has
+     * one byte per pixel, row by row.
+     */
+    bool Reference_Rasterize(Surface *dst, 
+                             const void *commands, Size size, U64 count,
+                             Out U8 *ambiguous = nullptr) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_REFERENCE_HPP_INCLUDED
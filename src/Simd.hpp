@@ -0,0 +1,65 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Simd.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#ifndef SBMR_SIMD_HPP_INCLUDED
+#define SBMR_SIMD_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+// NOTE(ilya.a): SSE2 is baseline on x64, so no runtime dispatch is done.
+// Other architectures are using scalar fallbacks.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+    #define BMR_SIMD_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define BMR_SIMD_SSE2 0
+#endif
+
+
+/*
+ * Multiplies two 8-bit values, treating them as fractions of 255, with
+ * correct rounding. Every blending kernel is using it, so SIMD and scalar
+ * paths produces same results.
+ */
+constexpr U8
+Mul8(U32 a, U32 b) noexcept
+{
+    U32 t = a * b + 128;
+    return (U8)((t + (t >> 8)) >> 8);
+}
+
+
+#if BMR_SIMD_SSE2
+
+/*
+ * Same as `Mul8`, but for eight 16-bit lanes, each holding value in [0; 255].
+ */
+inline __m128i
+Simd_Mul8(__m128i a, __m128i b) noexcept
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/*
+ * Broadcasts alpha lane of two unpacked BGRA pixels to the other lanes.
+ */
+inline __m128i
+Simd_BroadcastAlpha(__m128i pixels) noexcept
+{
+    pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+#endif  // BMR_SIMD_SSE2
+
+#endif  // SBMR_SIMD_HPP_INCLUDED
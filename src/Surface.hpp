@@ -0,0 +1,89 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Surface.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#ifndef SBMR_SURFACE_HPP_INCLUDED
+#define SBMR_SURFACE_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Coloring.hpp"
+
+
+/*
+ * Layout of single pixel in memory.
+ */
+enum class PixelFormat {
+    BGRA8888 = 0,  // Same as `Color4`.
+    RGB565   = 1,
+    INDEXED8 = 2,  // Index into `ColorPalette`.
+    RGBA8888 = 3,  // Red and blue of `Color4` are swapped.
+};
+
+
+constexpr U64
+GetBytesPerPixel(PixelFormat format) noexcept
+{
+    switch (format) {
+        case (PixelFormat::RGB565):   return 2;
+        case (PixelFormat::INDEXED8): return 1;
+        case (PixelFormat::BGRA8888):
+        default:                      return 4;
+    }
+}
+
+
+/*
+ * Colors of `INDEXED8` surfaces.
+ *
+ * `Inverse` maps color, truncated to RGB555, to the nearest palette entry,
+ * so packing of color is a single lookup.
+ */
+struct ColorPalette {
+    Color4 Colors[256];
+    U32    Count;
+    U8     Inverse[1 << 15];
+};
+
+
+/*
+ * Block of pixels which render commands can be rasterized into.
+ *
+ * Backbuffer of the window is a surface, as well as every offscreen
+ * render target.
+ */
+struct Surface {
+    void *Buffer;
+    U64   Width;
+    U64   Height;
+    U64   Pitch;    // NOTE(ilya.a): Bytes between two rows.
+
+    PixelFormat         Format;
+    const ColorPalette *Palette;  // NOTE(ilya.a): Only for `INDEXED8`.
+
+    // NOTE(ilya.a): Coordinates of the first pixel. Commands are given in
+    // coordinates of whatever surface is part of, e.g. canvas for its
+    // tiles. Zero for standalone surfaces.
+    S64 X;
+    S64 Y;
+};
+
+
+/*
+ * Address of pixel, which `x` and `y` are in coordinates of surface.
+ */
+inline U8 *
+GetPixelAddress(const Surface *s, S64 x, S64 y) noexcept
+{
+    return (U8 *)s->Buffer 
+        + (y - s->Y) * (S64)s->Pitch 
+        + (x - s->X) * (S64)GetBytesPerPixel(s->Format);
+}
+
+
+#endif  // SBMR_SURFACE_HPP_INCLUDED
@@ -0,0 +1,60 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Thread.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Threading primitives. Implemented in `Win32/Thread.cpp` and
+ * `Linux/Thread.cpp`.
+ * */
+
+#ifndef SBMR_THREAD_HPP_INCLUDED
+#define SBMR_THREAD_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+
+namespace BMR {
+
+    typedef void (*ThreadProc)(void *data) noexcept;
+
+    struct Thread;
+    struct Semaphore;
+
+    Thread *Thread_Start(ThreadProc proc, void *data) noexcept;
+    void Thread_Join(Thread *thread) noexcept;
+
+    /*
+     * Number of logical processors, which process can run on.
+     */
+    U32 Thread_GetProcessorCount() noexcept;
+
+    Semaphore *Semaphore_Create() noexcept;
+    void Semaphore_Destroy(Semaphore *semaphore) noexcept;
+    void Semaphore_Wait(Semaphore *semaphore) noexcept;
+    void Semaphore_Post(Semaphore *semaphore, U32 count) noexcept;
+
+    /*
+     * Returns value, which was stored before addition.
+     */
+    inline U64
+    Atomic_FetchAdd(volatile U64 *p, U64 value) noexcept
+    {
+#if defined(_MSC_VER)
+        return (U64)_InterlockedExchangeAdd64((volatile long long *)p, (long long)value);
+#else
+        return __atomic_fetch_add(p, value, __ATOMIC_ACQ_REL);
+#endif
+    }
+
+};  // namespace BMR
+
+#endif  // SBMR_THREAD_HPP_INCLUDED
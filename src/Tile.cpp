@@ -0,0 +1,114 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Tile.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <string.h>
+
+#include "Tile.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Command.hpp"
+
+
+#define BMR_TILE_HASH_SEED  0xCBF29CE484222325ULL
+#define BMR_TILE_HASH_PRIME 0x100000001B3ULL
+
+
+namespace BMR {
+
+    /*
+     * FNV-1a over 32-bit words. Every command is multiple of 4 bytes,
+     * padding in it is zeroed by `_PushRenderCommand`.
+     */
+    InternalFunc U64
+    _HashCommand(const U8 *command, Size size) noexcept
+    {
+        U64 h = BMR_TILE_HASH_SEED;
+
+        for (Size i = 0; i + 4 <= size; i += 4) {
+            U32 word;
+            memcpy(&word, command + i, sizeof(word));
+            h = (h ^ word) * BMR_TILE_HASH_PRIME;
+        }
+
+        return h;
+    }
+
+    void 
+    TileCache_Invalidate(TileCache *cache) noexcept
+    {
+        cache->IsValid = false;
+    }
+
+    U64 
+    TileCache_Update(TileCache *cache, 
+                     const U8 *commands, U64 count, const Clip &target) noexcept
+    {
+        U64 columns = (U64)(target.X1 - target.X0 + BMR_TILE_SIZE - 1) / BMR_TILE_SIZE;
+        U64 rows = (U64)(target.Y1 - target.Y0 + BMR_TILE_SIZE - 1) / BMR_TILE_SIZE;
+
+        if (columns != cache->Columns || rows != cache->Rows) {
+            cache->Columns = columns;
+            cache->Rows = rows;
+            cache->IsValid = false;
+        }
+
+        // NOTE(ilya.a): Old hashes are kept until all commands are
+        // hashed, new ones are accumulated here.
+        PersistVar U64 next[BMR_TILE_MAX_COUNT];
+        for (U64 i = 0; i < columns * rows; ++i) {
+            next[i] = BMR_TILE_HASH_SEED;
+        }
+
+        const U8 *cursor = commands;
+        for (U64 commandIdx = 0; commandIdx < count; ++commandIdx) {
+            RenderCommandType type = *((const RenderCommandType *)cursor);
+            Size size = Command_GetSize(type);
+            Clip bounds = Command_GetBounds(cursor, target);
+            U64 h = _HashCommand(cursor, size);
+            cursor += size;
+
+            if (bounds.IsEmpty()) {
+                continue;
+            }
+
+            // NOTE(ilya.a): Pixels of render target or canvas may change
+            // without any change of command, which points to it.
+            if (type == RenderCommandType::COMPOSITE || type == RenderCommandType::SPRITE 
+                || type == RenderCommandType::CANVAS) {
+                h ^= ++cache->Salt;
+            }
+
+            U64 tx0 = (U64)(bounds.X0 - target.X0) / BMR_TILE_SIZE;
+            U64 tx1 = (U64)(bounds.X1 - target.X0 - 1) / BMR_TILE_SIZE;
+            U64 ty0 = (U64)(bounds.Y0 - target.Y0) / BMR_TILE_SIZE;
+            U64 ty1 = (U64)(bounds.Y1 - target.Y0 - 1) / BMR_TILE_SIZE;
+
+            for (U64 ty = ty0; ty <= ty1; ++ty) {
+                U64 *row = next + ty * columns;
+
+                for (U64 tx = tx0; tx <= tx1; ++tx) {
+                    row[tx] = (row[tx] ^ h) * BMR_TILE_HASH_PRIME;
+                }
+            }
+        }
+
+        U64 dirty = 0;
+        for (U64 i = 0; i < columns * rows; ++i) {
+            cache->IsDirty[i] = !cache->IsValid || cache->Hashes[i] != next[i];
+            cache->Hashes[i] = next[i];
+            dirty += cache->IsDirty[i];
+        }
+
+        cache->IsValid = true;
+        return dirty;
+    }
+
+};  // namespace BMR
@@ -0,0 +1,55 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Tile.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Tile cache. Backbuffer is split in tiles, and commands, which touch
+ * each tile, are hashed. Tile, hash of which is the same as in previous
+ * frame, already has right pixels, so it's not rasterized again.
+ * */
+
+#ifndef SBMR_TILE_HPP_INCLUDED
+#define SBMR_TILE_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Raster.hpp"
+#include "BMR.hpp"
+
+
+#define BMR_TILE_SIZE 64
+#define BMR_TILE_MAX_COLUMNS ((BMR_FRAMEBUFFER_MAX_WIDTH  + BMR_TILE_SIZE - 1) / BMR_TILE_SIZE)
+#define BMR_TILE_MAX_ROWS    ((BMR_FRAMEBUFFER_MAX_HEIGHT + BMR_TILE_SIZE - 1) / BMR_TILE_SIZE)
+#define BMR_TILE_MAX_COUNT   (BMR_TILE_MAX_COLUMNS * BMR_TILE_MAX_ROWS)
+
+
+namespace BMR {
+
+    struct TileCache {
+        U64  Hashes[BMR_TILE_MAX_COUNT];  // NOTE(ilya.a): Of commands, which pixels came from.
+        bool IsDirty[BMR_TILE_MAX_COUNT];
+        U64  Columns;
+        U64  Rows;
+        U64  Salt;
+        bool IsValid;
+    };
+
+    /*
+     * Forgets hashes, so every tile is rasterized next time. Must be
+     * called, when pixels change without commands.
+     */
+    void TileCache_Invalidate(TileCache *cache) noexcept;
+
+    /*
+     * Hashes commands per tile of `target`, and marks tiles, hash of
+     * which has changed, as dirty. Returns number of dirty tiles.
+     */
+    U64 TileCache_Update(TileCache *cache, 
+                         const U8 *commands, U64 count, const Clip &target) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_TILE_HPP_INCLUDED
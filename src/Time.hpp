@@ -0,0 +1,52 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Time.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Monotonic clock and sleeping. Implemented in `Win32/Time.cpp` and
+ * `Linux/Time.cpp`.
+ * */
+
+#ifndef SBMR_TIME_HPP_INCLUDED
+#define SBMR_TIME_HPP_INCLUDED
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Simd.hpp"
+
+
+#define BMR_NS_PER_SECOND 1000000000ull
+#define BMR_NS_PER_MS     1000000ull
+
+
+namespace BMR {
+
+    /*
+     * Nanoseconds since some unspecified point, never going back.
+     */
+    U64 Time_Now() noexcept;
+
+    /*
+     * Sleeps at least `ns` nanoseconds. Scheduler may oversleep by a
+     * timer tick or more.
+     */
+    void Time_Sleep(U64 ns) noexcept;
+
+    /*
+     * Hint for processor, that it's spinning in a wait loop.
+     */
+    inline void
+    Time_Relax() noexcept
+    {
+#if BMR_SIMD_SSE2
+        _mm_pause();
+#endif
+    }
+
+};  // namespace BMR
+
+#endif  // SBMR_TIME_HPP_INCLUDED
@@ -10,25 +10,35 @@
 #ifndef SBMR_TYPES_HPP_INCLUDED
 #define SBMR_TYPES_HPP_INCLUDED
 
-typedef signed char     S8;
-typedef signed short    S16;
-typedef signed int      S32;
-typedef signed long     S64;
+#include <stddef.h>
 
-typedef unsigned char   U8;
-typedef unsigned short  U16;
-typedef unsigned int    U32;
-typedef unsigned long   U64;
+// NOTE(ilya.a): `long` is only 32 bits on Windows, so 64-bit types are
+// `long long`, and `Size` is whatever pointer difference fits into.
+typedef signed char        S8;
+typedef signed short       S16;
+typedef signed int         S32;
+typedef signed long long   S64;
+
+typedef unsigned char      U8;
+typedef unsigned short     U16;
+typedef unsigned int       U32;
+typedef unsigned long long U64;
 
 #define MAX_U8  255
 #define MAX_U16 65535
 #define MAX_U32 4294967295
 #define MAX_U64 18446744073709551615
 
-typedef float           F32;
-typedef double          F64;
+#define MAX_S32 2147483647
+#define MIN_S32 (-MAX_S32 - 1)
+
+typedef float              F32;
+typedef double             F64;
+
+typedef size_t             Size;
+typedef const char *       CStr;
 
-typedef unsigned long   Size;
-typedef const char *    CStr;
+static_assert(sizeof(S64) == 8 && sizeof(U64) == 8);
+static_assert(sizeof(Size) == sizeof(void *));
 
 #endif // SBMR_TYPES_HPP_INCLUDED
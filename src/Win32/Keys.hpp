@@ -14,6 +14,8 @@
 
 #define KEY_A 0x41
 #define KEY_D 0x44
+#define KEY_H 0x48
+#define KEY_M 0x4D
 #define KEY_S 0x53
 #define KEY_W 0x57
 
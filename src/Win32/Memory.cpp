@@ -0,0 +1,105 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Win32/Memory.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <Windows.h>
+
+#include "Memory.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+namespace BMR {
+
+    void *
+    Memory_Reserve(Size size, bool preferHugePages, 
+                   Out Size *granularity) noexcept
+    {
+        // NOTE(ilya.a): `MEM_LARGE_PAGES` requires SeLockMemoryPrivilege and
+        // must be committed at once together with reservation, which makes
+        // in-place growing impossible. So `preferHugePages` is ignored here.
+        (void)preferHugePages;
+
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        *granularity = info.dwPageSize;
+
+        return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    }
+
+    bool 
+    Memory_Commit(void *p, Size size, bool preferHugePages) noexcept
+    {
+        (void)preferHugePages;
+        return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    }
+
+    bool 
+    Memory_Decommit(void *p, Size size) noexcept
+    {
+        return VirtualFree(p, size, MEM_DECOMMIT) != 0;
+    }
+
+    void 
+    Memory_Release(void *p, Size size) noexcept
+    {
+        (void)size;
+
+        if (VirtualFree(p, 0, MEM_RELEASE) == 0) {
+            // TODO(ilya.a): Handle memory free error.
+            OutputDebugString("Failed to release memory!\n");
+        }
+    }
+
+    void *
+    Memory_MapFile(CStr path, Out Size *size) noexcept
+    {
+        *size = 0;
+
+        HANDLE file = CreateFileA(
+            path, GENERIC_READ, FILE_SHARE_READ, nullptr, 
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        HANDLE mapping = nullptr;
+
+        if (GetFileSizeEx(file, &fileSize) != 0 && fileSize.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+
+        void *p = nullptr;
+        if (mapping != nullptr) {
+            p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+            // NOTE(ilya.a): View keeps its own reference to the mapping.
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+
+        if (p != nullptr) {
+            *size = (Size)fileSize.QuadPart;
+        }
+        return p;
+    }
+
+    void 
+    Memory_UnmapFile(void *p, Size size) noexcept
+    {
+        (void)size;
+
+        if (p != nullptr) {
+            UnmapViewOfFile(p);
+        }
+    }
+
+};  // namespace BMR
@@ -0,0 +1,112 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Win32/Thread.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <Windows.h>
+
+#include "Thread.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Memory.hpp"
+
+
+namespace BMR {
+
+    struct Thread {
+        HANDLE     Handle;
+        ThreadProc Proc;
+        void      *Data;
+    };
+
+    struct Semaphore {
+        HANDLE Handle;
+    };
+
+    InternalFunc DWORD WINAPI
+    _RunThread(LPVOID data) noexcept
+    {
+        auto *thread = (Thread *)data;
+        thread->Proc(thread->Data);
+        return 0;
+    }
+
+    Thread *
+    Thread_Start(ThreadProc proc, void *data) noexcept
+    {
+        auto *thread = (Thread *)Memory_Allocate(sizeof(Thread));
+        if (thread == nullptr) {
+            return nullptr;
+        }
+
+        thread->Proc = proc;
+        thread->Data = data;
+        thread->Handle = CreateThread(nullptr, 0, _RunThread, thread, 0, nullptr);
+
+        if (thread->Handle == nullptr) {
+            Memory_Free(thread, sizeof(Thread));
+            return nullptr;
+        }
+
+        return thread;
+    }
+
+    void 
+    Thread_Join(Thread *thread) noexcept
+    {
+        WaitForSingleObject(thread->Handle, INFINITE);
+        CloseHandle(thread->Handle);
+        Memory_Free(thread, sizeof(Thread));
+    }
+
+    U32 
+    Thread_GetProcessorCount() noexcept
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (U32)info.dwNumberOfProcessors : 1;
+    }
+
+    Semaphore *
+    Semaphore_Create() noexcept
+    {
+        auto *semaphore = (Semaphore *)Memory_Allocate(sizeof(Semaphore));
+        if (semaphore == nullptr) {
+            return nullptr;
+        }
+
+        semaphore->Handle = CreateSemaphoreA(nullptr, 0, MAXLONG, nullptr);
+        if (semaphore->Handle == nullptr) {
+            Memory_Free(semaphore, sizeof(Semaphore));
+            return nullptr;
+        }
+
+        return semaphore;
+    }
+
+    void 
+    Semaphore_Destroy(Semaphore *semaphore) noexcept
+    {
+        CloseHandle(semaphore->Handle);
+        Memory_Free(semaphore, sizeof(Semaphore));
+    }
+
+    void 
+    Semaphore_Wait(Semaphore *semaphore) noexcept
+    {
+        WaitForSingleObject(semaphore->Handle, INFINITE);
+    }
+
+    void 
+    Semaphore_Post(Semaphore *semaphore, U32 count) noexcept
+    {
+        ReleaseSemaphore(semaphore->Handle, (LONG)count, nullptr);
+    }
+
+};  // namespace BMR
@@ -0,0 +1,64 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Win32/Time.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <Windows.h>
+
+#include "Time.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+
+namespace BMR {
+
+    U64
+    Time_Now() noexcept
+    {
+        PersistVar LARGE_INTEGER frequency = {};
+        if (frequency.QuadPart == 0) {
+            QueryPerformanceFrequency(&frequency);
+        }
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+
+        // NOTE(ilya.a): Split, so multiplication doesn't overflow.
+        U64 ticks = (U64)now.QuadPart;
+        U64 hz = (U64)frequency.QuadPart;
+        return ticks / hz * BMR_NS_PER_SECOND + ticks % hz * BMR_NS_PER_SECOND / hz;
+    }
+
+    void
+    Time_Sleep(U64 ns) noexcept
+    {
+        // NOTE(ilya.a): High resolution timer isn't rounded up to 15.6 ms
+        // tick, but only exists since Windows 10 1803.
+        PersistVar HANDLE timer = CreateWaitableTimerExW(
+            nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+        if (timer != nullptr) {
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)(ns / 100);  // NOTE(ilya.a): Relative, in 100 ns.
+
+            if (SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(timer, INFINITE);
+                return;
+            }
+        }
+
+        Sleep((DWORD)(ns / BMR_NS_PER_MS));
+    }
+
+};  // namespace BMR
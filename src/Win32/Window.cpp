@@ -0,0 +1,127 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/Win32/Window.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * GDI window backend.
+ * */
+
+#include <Windows.h>
+
+#include "BMR.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "Backend.hpp"
+#include "Win32/Misc.hpp"
+#include "Win32/ScopedDC.hpp"
+
+
+GlobalVar struct {
+    // NOTE(ilya.a): Channel masks of `BI_BITFIELDS` follow the header.
+    struct {
+        BITMAPINFOHEADER Header;
+        DWORD Masks[3];
+    } Info;
+
+    HWND Window;
+    S32 XOffset;
+    S32 YOffset;
+} Win32;
+
+
+namespace BMR {
+
+    InternalFunc void
+    _UpdateWindow(HDC dc,
+                  S32 windowXOffset,
+                  S32 windowYOffset,
+                  S32 windowWidth,
+                  S32 windowHeight) noexcept
+    {
+        const Surface *frame = GetFrame();
+        const FrameLayout layout = GetFrameLayout();
+
+        // NOTE(ilya.a): DIB rows are padded same as ours, so width of bitmap
+        // is the pitch. Only `Width` pixels are blitted from each row.
+        // Negative height makes DIB top-down.
+        BITMAPINFOHEADER &header = Win32.Info.Header;
+        header.biSize          = sizeof(header);
+        header.biWidth         = (LONG)(frame->Pitch / 4);
+        header.biHeight        = layout.IsBottomUp ? (LONG)frame->Height : -(LONG)frame->Height;
+        header.biPlanes        = 1;
+        header.biBitCount      = 32;      // NOTE: Align to WORD
+        header.biCompression   = BI_RGB;
+        header.biSizeImage     = 0;
+        header.biXPelsPerMeter = 0;
+        header.biYPelsPerMeter = 0;
+        header.biClrUsed       = 0;
+        header.biClrImportant  = 0;
+
+        if (frame->Format == PixelFormat::RGBA8888) {
+            header.biCompression = BI_BITFIELDS;
+            Win32.Info.Masks[0] = 0x000000FF;  // NOTE(ilya.a): Red.
+            Win32.Info.Masks[1] = 0x0000FF00;
+            Win32.Info.Masks[2] = 0x00FF0000;
+        }
+
+        StretchDIBits(
+            dc,
+            Win32.XOffset, Win32.YOffset, (S32)frame->Width, (S32)frame->Height,
+            windowXOffset, windowYOffset, windowWidth,       windowHeight,
+            frame->Buffer, (const BITMAPINFO *)&Win32.Info,
+            DIB_RGB_COLORS, SRCCOPY
+        );
+    }
+
+    InternalFunc void
+    _Present(const Surface *frame) noexcept
+    {
+        (void)frame;
+
+        // TODO(ilya.a): Check how it's differs with event thing.
+        auto dc = ScopedDC(Win32.Window);
+
+        RECT windowRect;
+        GetClientRect(Win32.Window, &windowRect);
+        S32 x = windowRect.left;
+        S32 y = windowRect.top;
+        S32 width = 0, height = 0;
+        GetRectSize(&windowRect, &width, &height);
+
+        _UpdateWindow(dc.Handle, x, y, width, height);
+    }
+
+    void 
+    BeginDrawing(HWND window) noexcept 
+    {
+        Win32.Window = window;
+        Backend_SetPresent(_Present);
+        BeginDrawing(GetBackbuffer());
+    }
+
+    void 
+    Update(HWND window) noexcept 
+    {
+        PAINTSTRUCT ps = {0};
+        HDC dc = BeginPaint(window, &ps);
+
+        if (dc == nullptr) {
+            // TODO(ilya.a): Handle error
+        } else {
+            S32 x = ps.rcPaint.left;
+            S32 y = ps.rcPaint.top;
+            S32 width = 0, height = 0;
+            GetRectSize(&(ps.rcPaint), &width, &height);
+            _UpdateWindow(dc, x, y, width, height);
+        }
+
+        EndPaint(window, &ps);
+    }
+
+};  // namespace BMR
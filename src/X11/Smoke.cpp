@@ -0,0 +1,156 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/X11/Smoke.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * Smoke test of X11 backend. Opens window, presents few frames, and reads
+ * window back to check, that the last frame is what X server shows. Run
+ * under Xvfb with 24-bit screen, e.g.
+ *
+ *   xvfb-run -a -s "-screen 0 640x480x24" sbmr-x11-smoke [--no-shm]
+ *
+ * Without `--no-shm` it fails, unless frames went through MIT-SHM, so
+ * fallback can't silently pass for shared path.
+ * */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Coloring.hpp"
+#include "Surface.hpp"
+#include "BMR.hpp"
+#include "X11/Window.hpp"
+
+
+#define SMOKE_WIDTH  200
+#define SMOKE_HEIGHT 150
+#define SMOKE_FRAMES 8
+
+
+/*
+ * Compares window with last frame. Alpha is not kept by X server.
+ */
+InternalFunc bool
+Smoke_Compare(Display *display, ::Window window)
+{
+    const Surface *frame = BMR::GetFrame();
+    if (frame->Buffer == nullptr
+        || frame->Width != SMOKE_WIDTH || frame->Height != SMOKE_HEIGHT) {
+        fputs("No frame was finished!\n", stderr);
+        return false;
+    }
+
+    XImage *image = XGetImage(
+        display, window, 0, 0, SMOKE_WIDTH, SMOKE_HEIGHT, AllPlanes, ZPixmap);
+    if (image == nullptr) {
+        fputs("Failed to read window back!\n", stderr);
+        return false;
+    }
+
+    bool isSame = true;
+    for (U64 y = 0; y < SMOKE_HEIGHT && isSame; ++y) {
+        const U32 *row = (const U32 *)((const U8 *)frame->Buffer + y * frame->Pitch);
+
+        for (U64 x = 0; x < SMOKE_WIDTH; ++x) {
+            U32 expected = row[x] & 0xFFFFFF;
+            U32 actual = (U32)XGetPixel(image, (int)x, (int)y) & 0xFFFFFF;
+
+            if (expected != actual) {
+                fprintf(stderr, "Pixel (%llu, %llu): expected %06x, got %06x\n",
+                        (unsigned long long)x, (unsigned long long)y, expected, actual);
+                isSame = false;
+                break;
+            }
+        }
+    }
+
+    XDestroyImage(image);
+    return isSame;
+}
+
+int
+main(int argc, char **argv)
+{
+    bool preferShared = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--no-shm") == 0) {
+            preferShared = false;
+        } else {
+            fprintf(stderr, "Usage: %s [--no-shm]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Display *display = XOpenDisplay(nullptr);
+    if (display == nullptr) {
+        fputs("Failed to open X display!\n", stderr);
+        return 1;
+    }
+
+    S32 screen = DefaultScreen(display);
+    ::Window window = XCreateSimpleWindow(
+        display, RootWindow(display, screen),
+        0, 0, SMOKE_WIDTH, SMOKE_HEIGHT, 0,
+        BlackPixel(display, screen), BlackPixel(display, screen));
+
+    XSelectInput(display, window, StructureNotifyMask);
+    XMapWindow(display, window);
+
+    // NOTE(ilya.a): Frames put before window is mapped are lost.
+    for (;;) {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type == MapNotify) {
+            break;
+        }
+    }
+
+    BMR::Init();
+    if (!BMR::X11_Attach(display, window, preferShared)) {
+        fputs("Failed to attach renderer to window!\n", stderr);
+        return 1;
+    }
+    BMR::Resize(SMOKE_WIDTH, SMOKE_HEIGHT);
+
+    bool isShared = BMR::X11_IsShared();
+
+    for (U32 frame = 0; frame < SMOKE_FRAMES; ++frame) {
+        BMR::BeginDrawing(display, window);
+
+        BMR::SetClearColor(Color4((U8)(frame * 30), 40, 80, MAX_U8));
+        BMR::Clear();
+        BMR::DrawRect(10 + frame * 10, 20, 40, 30, Color4(MAX_U8, (U8)(frame * 20), 0, MAX_U8));
+        BMR::DrawRect(0, SMOKE_HEIGHT - 10, SMOKE_WIDTH, 10, COLOR_WHITE);
+
+        BMR::EndDrawing();
+    }
+
+    // NOTE(ilya.a): Round trip, so the last put is done before readback.
+    XSync(display, False);
+
+    bool isPassed = Smoke_Compare(display, window);
+    if (preferShared && !isShared) {
+        fputs("Frames were not presented through MIT-SHM!\n", stderr);
+        isPassed = false;
+    }
+
+    printf("%s: %u frames presented, %s\n",
+           isShared ? "MIT-SHM" : "XPutImage", SMOKE_FRAMES, isPassed ? "ok" : "FAILED");
+
+    BMR::X11_Detach();
+    BMR::DeInit();
+
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+
+    return isPassed ? 0 : 1;
+}
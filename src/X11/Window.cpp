@@ -0,0 +1,270 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/X11/Window.cpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ * */
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include "X11/Window.hpp"
+
+#include "Types.hpp"
+#include "Macros.hpp"
+#include "Surface.hpp"
+#include "Memory.hpp"
+#include "Backend.hpp"
+#include "Debug.hpp"
+#include "BMR.hpp"
+
+
+// NOTE(ilya.a): Segment can hold biggest backbuffer, so it's never
+// reattached on resize. Pages are only backed, when they are touched.
+#define BMR_X11_SEGMENT_SIZE \
+    (AlignUp(BMR_FRAMEBUFFER_MAX_WIDTH * 4, BMR_CACHE_LINE_SIZE) * BMR_FRAMEBUFFER_MAX_HEIGHT)
+
+
+GlobalVar struct {
+    ::Display *Display;
+    ::Window Window;
+    GC Context;
+    ::Visual *Visual;
+    S32 Depth;
+
+    bool Shared;
+    XShmSegmentInfo Segment;
+
+    // NOTE(ilya.a): Put of previous frame, which X server may still be
+    // reading. Backbuffer can't be touched until it's done.
+    bool Pending;
+
+    bool AttachFailed;
+} X11;
+
+
+namespace BMR {
+
+    InternalFunc int
+    _TrapError(Display *display, XErrorEvent *error) noexcept
+    {
+        (void)display;
+        (void)error;
+
+        X11.AttachFailed = true;
+        return 0;
+    }
+
+    /*
+     * Attaches segment to X server. Fails on remote displays and when X
+     * server lives in other IPC namespace, errors of which are
+     * asynchronous, so they are trapped until round trip is done.
+     */
+    InternalFunc bool
+    _AttachSegment() noexcept
+    {
+        if (!XShmQueryExtension(X11.Display)) {
+            return false;
+        }
+
+        X11.Segment.shmid = shmget(IPC_PRIVATE, BMR_X11_SEGMENT_SIZE, IPC_CREAT | 0600);
+        if (X11.Segment.shmid < 0) {
+            return false;
+        }
+
+        X11.Segment.shmaddr = (char *)shmat(X11.Segment.shmid, nullptr, 0);
+
+        // NOTE(ilya.a): Marked for removal right away, so segment doesn't
+        // outlive us, if we crash. It's destroyed after last detach.
+        shmctl(X11.Segment.shmid, IPC_RMID, nullptr);
+
+        if (X11.Segment.shmaddr == (char *)-1) {
+            X11.Segment.shmaddr = nullptr;
+            return false;
+        }
+
+        X11.Segment.readOnly = True;
+        X11.AttachFailed = false;
+
+        XErrorHandler previous = XSetErrorHandler(_TrapError);
+        XShmAttach(X11.Display, &X11.Segment);
+        XSync(X11.Display, False);
+        XSetErrorHandler(previous);
+
+        if (X11.AttachFailed) {
+            shmdt(X11.Segment.shmaddr);
+            X11.Segment.shmaddr = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * X server reads segment while it's handling put request, so round
+     * trip is enough. It's made right before next frame is drawn, by then
+     * request is long done, and it's not waiting for present. Completion
+     * events are not used, because event loop of application would
+     * swallow them.
+     */
+    InternalFunc void
+    _WaitPresent() noexcept
+    {
+        if (X11.Pending) {
+            XSync(X11.Display, False);
+            X11.Pending = false;
+        }
+    }
+
+    InternalFunc void
+    _Present(const Surface *frame) noexcept
+    {
+        if (frame->Buffer == nullptr || frame->Width == 0 || frame->Height == 0) {
+            return;
+        }
+
+        // NOTE(ilya.a): Image is put as is, so it must match visual.
+        if (frame->Format != PixelFormat::BGRA8888 || GetFrameLayout().IsBottomUp) {
+            PersistVar bool isReported = false;
+            if (!isReported) {
+                Debug_Print("Layout of frame can't be presented by X11 backend!\n");
+                isReported = true;
+            }
+            return;
+        }
+
+        // NOTE(ilya.a): Rows are padded, so width of image is the pitch.
+        // Only `Width` pixels are put from each row.
+        XImage image = {};
+        image.width = (int)(frame->Pitch / 4);
+        image.height = (int)frame->Height;
+        image.format = ZPixmap;
+        image.data = (char *)frame->Buffer;
+        image.byte_order = LSBFirst;
+        image.bitmap_unit = 32;
+        image.bitmap_bit_order = LSBFirst;
+        image.bitmap_pad = 32;
+        image.depth = X11.Depth;
+        image.bytes_per_line = (int)frame->Pitch;
+        image.bits_per_pixel = 32;
+        image.red_mask = X11.Visual->red_mask;
+        image.green_mask = X11.Visual->green_mask;
+        image.blue_mask = X11.Visual->blue_mask;
+        image.obdata = (XPointer)&X11.Segment;
+        XInitImage(&image);
+
+        U8 *segment = (U8 *)X11.Segment.shmaddr;
+        bool inSegment = X11.Shared
+            && (U8 *)frame->Buffer >= segment
+            && (U8 *)frame->Buffer + frame->Pitch * frame->Height <= segment + BMR_X11_SEGMENT_SIZE;
+
+        if (inSegment) {
+            XShmPutImage(
+                X11.Display, X11.Window, X11.Context, &image,
+                0, 0, 0, 0, (unsigned)frame->Width, (unsigned)frame->Height, False);
+            X11.Pending = true;
+        } else {
+            XPutImage(
+                X11.Display, X11.Window, X11.Context, &image,
+                0, 0, 0, 0, (unsigned)frame->Width, (unsigned)frame->Height);
+        }
+
+        XFlush(X11.Display);
+    }
+
+    bool
+    X11_Attach(Display *display, ::Window window, bool preferShared) noexcept
+    {
+        X11.Display = display;
+        X11.Window = window;
+        X11.Pending = false;
+
+        XWindowAttributes attributes;
+        XGetWindowAttributes(display, window, &attributes);
+        X11.Visual = attributes.visual;
+        X11.Depth = attributes.depth;
+
+        if (X11.Visual->c_class != TrueColor || X11.Depth < 24
+            || X11.Visual->red_mask != 0xFF0000
+            || X11.Visual->green_mask != 0x00FF00
+            || X11.Visual->blue_mask != 0x0000FF) {
+            Debug_Print("Visual of window is not BGRX, frames can't be presented!\n");
+            return false;
+        }
+
+        X11.Context = XCreateGC(display, window, 0, nullptr);
+
+        X11.Shared = preferShared && _AttachSegment();
+        if (X11.Shared) {
+            Backend_SetFramebuffer(X11.Segment.shmaddr, BMR_X11_SEGMENT_SIZE);
+        } else if (preferShared) {
+            Debug_Print("MIT-SHM is unavailable, falling back to XPutImage!\n");
+        }
+
+        Backend_SetPresent(_Present);
+        return true;
+    }
+
+    void
+    X11_Detach() noexcept
+    {
+        if (X11.Display == nullptr) {
+            return;
+        }
+
+        _WaitPresent();
+        Backend_SetPresent(nullptr);
+
+        if (X11.Shared) {
+            Backend_SetFramebuffer(nullptr, 0);
+
+            XShmDetach(X11.Display, &X11.Segment);
+            XSync(X11.Display, False);
+            shmdt(X11.Segment.shmaddr);
+
+            X11.Segment = XShmSegmentInfo{};
+            X11.Shared = false;
+        }
+
+        if (X11.Context != nullptr) {
+            XFreeGC(X11.Display, X11.Context);
+            X11.Context = nullptr;
+        }
+
+        X11.Display = nullptr;
+    }
+
+    bool
+    X11_IsShared() noexcept
+    {
+        return X11.Shared;
+    }
+
+    void
+    BeginDrawing(Display *display, ::Window window) noexcept
+    {
+        X11.Display = display;
+        X11.Window = window;
+
+        _WaitPresent();
+        BeginDrawing(GetBackbuffer());
+    }
+
+    void
+    Update(Display *display, ::Window window) noexcept
+    {
+        X11.Display = display;
+        X11.Window = window;
+
+        _WaitPresent();
+        _Present(GetFrame());
+    }
+
+};  // namespace BMR
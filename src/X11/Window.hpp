@@ -0,0 +1,49 @@
+/*
+ * ============================================
+ * LIBSBMR
+ * ============================================
+ * FILE     src/X11/Window.hpp
+ * AUTHOR   Ilya Akkuzin <gr3yknigh1@gmail.com>
+ * LICENSE  Copyright (c) 2024 Ilya Akkuzin
+ * ============================================
+ *
+ * X11 window backend. Frames are presented with MIT-SHM, falls back to
+ * `XPutImage`, if X server can't share memory with us (remote display).
+ * */
+
+#ifndef SBMR_X11_WINDOW_HPP_INCLUDED
+#define SBMR_X11_WINDOW_HPP_INCLUDED
+
+#include <X11/Xlib.h>
+
+#include "Types.hpp"
+
+
+namespace BMR {
+
+    /*
+     * Binds renderer to window. Must be called after `BMR::Init`, and
+     * before window is resized, so backbuffer is placed in shared memory.
+     * Without `preferShared` frames are always put with `XPutImage`.
+     */
+    bool X11_Attach(Display *display, ::Window window, bool preferShared = true) noexcept;
+    void X11_Detach() noexcept;
+
+    /*
+     * Whether frames are presented through MIT-SHM segment.
+     */
+    bool X11_IsShared() noexcept;
+
+    /*
+     * Waits until X server has finished reading previous frame.
+     */
+    void BeginDrawing(Display *display, ::Window window) noexcept;
+
+    /*
+     * Presents last frame again. Called on `Expose`.
+     */
+    void Update(Display *display, ::Window window) noexcept;
+
+};  // namespace BMR
+
+#endif  // SBMR_X11_WINDOW_HPP_INCLUDED